@@ -11,25 +11,44 @@ CONF_DR_PIN = "dr_pin"
 CONF_PWR_PIN = "pwr_pin"
 CONF_TXEN_PIN = "txen_pin"
 
+ISR_OUTPUT = "it is switched from the DR interrupt"
+ISR_INPUT = "it needs an edge interrupt"
+
 DEPENDENCIES = ["spi"]
 
 nrf905_ns = cg.esphome_ns.namespace("nrf905")
 nRF905Component = nrf905_ns.class_("nRF905", fan.Fan, cg.PollingComponent)
 
+
+# Pins used from interrupts have to be pins of the chip itself. Expander pins used to be accepted, so say why they
+# no longer are instead of failing on the expander's keys
+def internal_pin(schema, reason):
+    def validator(value):
+        try:
+            return schema(value)
+        except cv.Invalid:
+            if isinstance(value, dict) and any(key in pins.PIN_SCHEMA_REGISTRY for key in value):
+                raise cv.Invalid(f"Must be a GPIO of the microcontroller, not an I/O expander pin: {reason}")
+            raise
+
+    return validator
+
+
 CONFIG_SCHEMA = (
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(nRF905Component),
             cv.Optional(CONF_CD_PIN): pins.gpio_input_pin_schema,
-            cv.Required(CONF_CE_PIN): pins.gpio_output_pin_schema,
+            # CE and TXEN are switched from the DR interrupt, AM and DR raise it
+            cv.Required(CONF_CE_PIN): internal_pin(pins.internal_gpio_output_pin_schema, ISR_OUTPUT),
             cv.Required(CONF_PWR_PIN): pins.gpio_output_pin_schema,
-            cv.Required(CONF_TXEN_PIN): pins.gpio_output_pin_schema,
-            cv.Optional(CONF_AM_PIN): pins.gpio_input_pin_schema,
-            cv.Optional(CONF_DR_PIN): pins.gpio_input_pin_schema,
+            cv.Required(CONF_TXEN_PIN): internal_pin(pins.internal_gpio_output_pin_schema, ISR_OUTPUT),
+            cv.Optional(CONF_AM_PIN): internal_pin(pins.internal_gpio_input_pin_schema, ISR_INPUT),
+            cv.Optional(CONF_DR_PIN): internal_pin(pins.internal_gpio_input_pin_schema, ISR_INPUT),
         }
     )
     .extend(cv.COMPONENT_SCHEMA)
-    .extend(spi.spi_device_schema(cs_pin_required=True))
+    .extend(spi.spi_device_schema(cs_pin_required=True, default_data_rate="1MHz"))
 )
 
 
@@ -25,14 +25,42 @@ void nRF905::setup() {
     this->_gpio_pin_cd->setup();
   }
   this->_gpio_pin_ce->setup();
+  this->_isr_pin_ce = this->_gpio_pin_ce->to_isr();
   if (this->_gpio_pin_dr != NULL) {
     this->_gpio_pin_dr->setup();
   }
   this->_gpio_pin_pwr->setup();
   this->_gpio_pin_txen->setup();
+  this->_isr_pin_txen = this->_gpio_pin_txen->to_isr();
+
+  // With the DR pin wired up the status lines are serviced from edge interrupts instead of polling the status
+  // register over SPI on every loop
+  if (this->_gpio_pin_dr != NULL) {
+    this->_gpio_pin_dr->attach_interrupt(nRF905::dataReadyIsr, this, gpio::INTERRUPT_ANY_EDGE);
+    if (this->_gpio_pin_am != NULL) {
+      this->_gpio_pin_am->attach_interrupt(nRF905::statusLineIsr, this, gpio::INTERRUPT_ANY_EDGE);
+    }
+    this->_statusPolling = false;
+  }
 
   this->setMode(PowerDown);
 
+  // Make sure the chip can be talked to at the configured SPI clock, step down until it works
+  while (this->spiSelfTest() == false) {
+    uint32_t dataRate = this->lowerDataRate(this->data_rate_);
+
+    if (dataRate == 0) {
+      ESP_LOGE(TAG, "SPI self-test failed at %u kHz, check wiring", this->data_rate_ / 1000);
+      break;
+    }
+
+    ESP_LOGW(TAG, "SPI self-test failed at %u kHz, falling back to %u kHz", this->data_rate_ / 1000,
+             dataRate / 1000);
+    this->spi_teardown();
+    this->set_data_rate(dataRate);
+    this->spi_setup();
+  }
+
   this->readConfigRegisters();
 
   this->_config.band = true;
@@ -73,6 +101,7 @@ void nRF905::dump_config() {
   ESP_LOGCONFIG(TAG, "nRF905 Configuration:");
 
   LOG_PIN("  CS Pin:", this->cs_);
+  ESP_LOGCONFIG(TAG, "  SPI data rate: %u kHz", this->data_rate_ / 1000);
   if (this->_gpio_pin_am != NULL) {
     LOG_PIN("  AM Pin:", this->_gpio_pin_am);
   }
@@ -85,62 +114,171 @@ void nRF905::dump_config() {
   LOG_PIN("  CE Pin:", this->_gpio_pin_ce);
   LOG_PIN("  PWR Pin:", this->_gpio_pin_pwr);
   LOG_PIN("  TXEN Pin:", this->_gpio_pin_txen);
+  ESP_LOGCONFIG(TAG, "  Status: %s", this->_statusPolling ? "SPI polling" : "DR/AM interrupts");
+  ESP_LOGCONFIG(TAG, "  RX queue: %u frames", NRF905_RX_QUEUE_SIZE);
 }
 
 void nRF905::loop() {
-  static uint8_t lastState = 0x00;
-  static bool addrMatch;
+  if (!this->_servicedExternally) {
+    this->service();
+  }
+}
+
+void nRF905::service(void) {
   uint8_t buffer[NRF905_MAX_FRAMESIZE];
+  RxFrame frame;
+  uint8_t width;
+  uint8_t state;
+  uint8_t head;
+  uint8_t used;
+
+  // Start a transmission that was waiting for the radio to power up
+  if (this->_txPending && (this->updateTransition() != PoweringUp)) {
+    this->_txPending = false;
+    this->beginTx();
+  }
 
-  uint8_t state = this->readStatus() & ((1 << NRF905_STATUS_DR) | (1 << NRF905_STATUS_AM));
-  if (lastState != state) {
-    ESP_LOGV(TAG, "State change: 0x%02X -> 0x%02X", lastState, state);
-    if (state == ((1 << NRF905_STATUS_DR) | (1 << NRF905_STATUS_AM))) {
-      addrMatch = false;
+  if (this->_statusPolling) {
+    state = this->readStatus() & ((1 << NRF905_STATUS_DR) | (1 << NRF905_STATUS_AM));
+  } else if (this->_statusEdge) {
+    // Clear before sampling, so an edge arriving while we handle this one is not lost
+    this->_statusEdge = false;
+    state = this->readStatusLines();
+  } else if (this->_mode == Transmit) {
+    // No new edge, only the transmit timeout needs checking
+    state = this->_lastState;
+  } else {
+    return;
+  }
 
-      // Read data
-      this->readRxPayload(buffer, NRF905_MAX_FRAMESIZE);
-      ESP_LOGV(TAG, "RX Complete: %s", hexArrayToStr(buffer, NRF905_MAX_FRAMESIZE));
+  if (this->_mode == Transmit) {
+    if (this->txComplete(state)) {
+      this->setMode(this->nextMode);
 
-      if (this->onRxComplete != NULL) {
-        this->onRxComplete(buffer, NRF905_MAX_FRAMESIZE);
+      if (this->onTxReady != NULL) {
+        this->onTxReady();
       }
-    } else if (state == (1 << NRF905_STATUS_DR)) {
-      addrMatch = false;
-
-      // if (this->retransmitCounter > 0) {
-      //   --this->retransmitCounter;
-      // } else {
+    } else if ((micros() - this->_txStartTime) > (MAX_TRANSMIT_TIME * 1000UL)) {
+      ESP_LOGW(TAG, "Transmit timeout");
       this->setMode(this->nextMode);
 
       if (this->onTxReady != NULL) {
         this->onTxReady();
       }
-      // }
+    } else {
+      if (this->_statusPolling && (state & (1 << NRF905_STATUS_DR))) {
+        // Copy sent, pulse CE for the next one
+        ++this->_txCopies;
+        this->_gpio_pin_ce->digital_write(false);
+        delayMicroseconds(NRF905_CE_PULSE);
+        this->_gpio_pin_ce->digital_write(true);
+        state = 0x00;
+      }
+
+      this->_lastState = state;
+      return;
+    }
+
+    if (this->_mode == Transmit) {
+      // onTxReady started the next transmission
+      this->_lastState = state;
+      return;
+    }
+
+    // The DR interrupt may have opened the receive window well before this loop, so a reply can already be waiting
+    this->_lastState = 0x00;
+  }
+
+  if (this->_lastState != state) {
+    ESP_LOGV(TAG, "State change: 0x%02X -> 0x%02X", this->_lastState, state);
+    if (state == ((1 << NRF905_STATUS_DR) | (1 << NRF905_STATUS_AM))) {
+      this->_addrMatch = false;
+
+      // Read data; only the configured payload width holds valid data
+      width = this->_config.rx_payload_width;
+      if (width > NRF905_MAX_FRAMESIZE) {
+        width = NRF905_MAX_FRAMESIZE;
+      }
+
+      head = this->_rxHead.load(std::memory_order_relaxed);
+      used = head - this->_rxTail.load(std::memory_order_acquire);
+
+      if (used >= NRF905_RX_QUEUE_SIZE) {
+        // Consumer is behind; the frame still has to be read to clear DR, but it is dropped
+        this->readRxPayload(buffer, width);
+        ++this->_rxOverflows;
+        ESP_LOGW(TAG, "RX queue full, frame dropped (%u total)", this->_rxOverflows);
+      } else {
+        RxFrame *const pFrame = &this->_rxQueue[head & (NRF905_RX_QUEUE_SIZE - 1)];
+
+        // Read straight into the queue slot
+        this->readRxPayload(pFrame->data, width);
+        pFrame->length = width;
+        pFrame->timestamp = millis();
+        ESP_LOGV(TAG, "RX Complete: %s", hexArrayToStr(pFrame->data, width));
+
+        this->_rxHead.store(head + 1, std::memory_order_release);
+
+        if (++used > this->_rxHighWater) {
+          this->_rxHighWater = used;
+        }
+      }
+
+      // A callback consumer gets the queued frames right away, through the same queue and counters
+      if (this->onRxComplete != NULL) {
+        while (this->readRxFrame(&frame)) {
+          this->onRxComplete(frame.data, frame.length);
+        }
+      }
+
+      // Reading the payload cleared DR and AM; a frame arriving before the next sample must count as a change
+      state = 0x00;
+    } else if (state == (1 << NRF905_STATUS_DR)) {
+      // Data ready without address match only happens at the end of a transmission, handled above
+      this->_addrMatch = false;
     } else if (state == (1 << NRF905_STATUS_AM)) {
-      addrMatch = true;
+      this->_addrMatch = true;
       ESP_LOGD(TAG, "Address match detected");
 
       // if (onAddrMatch != NULL)
       //   onAddrMatch(this);
-    } else if (state == 0 && addrMatch) {
-      addrMatch = false;
+    } else if (state == 0 && this->_addrMatch) {
+      this->_addrMatch = false;
       ESP_LOGD(TAG, "Invalid RX data received");
       // if (onRxInvalid != NULL)
       //   onRxInvalid(this);
     }
 
-    lastState = state;
+    this->_lastState = state;
   }
 
   // _drPrev = _drNew;
 }
 
+bool nRF905::readRxFrame(RxFrame *const pFrame) {
+  uint8_t tail = this->_rxTail.load(std::memory_order_relaxed);
+
+  if (tail == this->_rxHead.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  *pFrame = this->_rxQueue[tail & (NRF905_RX_QUEUE_SIZE - 1)];
+  this->_rxTail.store(tail + 1, std::memory_order_release);
+
+  return true;
+}
+
 void nRF905::setMode(const Mode mode) {
+  // Keep the DR interrupt away from the pins from here on
+  if (mode != Transmit) {
+    this->_isrTx = false;
+  }
+
   // Set power
   switch (mode) {
     case PowerDown:
       this->_gpio_pin_pwr->digital_write(false);
+      this->_txPayloadShadowValid = false;  // Only the configuration is kept while powered down
       break;
 
     default:
@@ -171,22 +309,156 @@ void nRF905::setMode(const Mode mode) {
       break;
   }
 
+  if (mode != this->_mode) {
+    uint32_t now = micros();
+    uint32_t settledAt = now;
+
+    // Mode time accounting
+    const uint32_t seq = this->_modeTimeSeq.load(std::memory_order_relaxed);
+    this->_modeTimeSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    this->_modeTime[this->_mode] += millis() - this->_modeSince;
+    this->_modeSince = millis();
+    this->_modeTimeMode = mode;
+    this->_modeTimeSeq.store(seq + 2, std::memory_order_release);
+
+    // Track the time the chip needs before it is ready in the new mode
+    if (mode == PowerDown) {
+      this->_transition = Settled;
+      this->_txPending = false;
+    } else if ((this->_mode == PowerDown) || (this->updateTransition() == PoweringUp)) {
+      if (this->_mode == PowerDown) {
+        this->_settledAt = now + NRF905_POWERUP_TIME;
+      }
+      this->_transition = PoweringUp;
+      settledAt = this->_settledAt;
+      if ((mode == Transmit) || (mode == Receive)) {
+        settledAt += NRF905_SETTLE_TIME;
+      }
+    } else if (mode == Transmit) {
+      this->_transition = TxSettling;
+      settledAt = now + NRF905_SETTLE_TIME;
+    } else if (mode == Receive) {
+      this->_transition = RxSettling;
+      settledAt = now + NRF905_SETTLE_TIME;
+    } else {
+      this->_transition = Settled;
+    }
+    this->_settledAt = settledAt;
+  }
+
   this->_mode = mode;
 }
 
+uint64_t nRF905::getModeTime(const Mode mode) {
+  uint32_t seq;
+  uint64_t time;
+
+  // Retry while the radio side is in the middle of an update
+  do {
+    seq = this->_modeTimeSeq.load(std::memory_order_acquire);
+    time = this->_modeTime[mode];
+    if (mode == this->_modeTimeMode) {
+      time += millis() - this->_modeSince;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((seq & 1) || (seq != this->_modeTimeSeq.load(std::memory_order_relaxed)));
+
+  return time;
+}
+
+Transition nRF905::updateTransition(void) {
+  if ((this->_transition != Settled) && ((int32_t) (micros() - this->_settledAt) >= 0)) {
+    this->_transition = Settled;
+  }
+
+  return this->_transition;
+}
+
+void nRF905::standbyBegin(void) {
+  // Register access needs standby; nested and batched accesses only switch once
+  if (this->_standbyDepth++ == 0) {
+    this->_standbyMode = this->_mode;
+    if (this->_mode != Idle) {
+      this->setMode(Idle);
+    }
+  }
+}
+
+void nRF905::standbyEnd(void) {
+  if (--this->_standbyDepth == 0) {
+    // Leave it alone if a mode change happened in between
+    if ((this->_standbyMode != Idle) && (this->_mode == Idle)) {
+      this->setMode(this->_standbyMode);
+    }
+  }
+}
+
+void nRF905::beginBatch(void) { this->standbyBegin(); }
+
+void nRF905::endBatch(void) { this->standbyEnd(); }
+
+bool nRF905::spiSelfTest(void) {
+  static const uint8_t patterns[2][4] = {{0xA5, 0x5A, 0x0F, 0xF0}, {0x5A, 0xA5, 0xF0, 0x0F}};
+  AddressBuffer buffer;
+  bool ok = true;
+
+  // Walk alternating bit patterns through the RX address registers (5..8), they are rewritten during setup
+  this->standbyBegin();
+  for (uint8_t i = 0; (i < 2) && ok; ++i) {
+    buffer.command = NRF905_COMMAND_W_CONFIG | 5;
+    (void) memcpy(buffer.address, patterns[i], sizeof(buffer.address));
+    this->spiTransfer((uint8_t *) &buffer, sizeof(AddressBuffer));
+
+    buffer.command = NRF905_COMMAND_R_CONFIG | 5;
+    (void) memset(buffer.address, 0, sizeof(buffer.address));
+    this->spiTransfer((uint8_t *) &buffer, sizeof(AddressBuffer));
+
+    ok = (memcmp(buffer.address, patterns[i], sizeof(buffer.address)) == 0);
+  }
+  this->standbyEnd();
+
+  // Register contents changed behind the shadow's back
+  this->_configShadowValid = false;
+
+  return ok;
+}
+
+uint32_t nRF905::lowerDataRate(const uint32_t dataRate) {
+  static const uint32_t rates[] = {spi::DATA_RATE_10MHZ, spi::DATA_RATE_8MHZ, spi::DATA_RATE_5MHZ,
+                                   spi::DATA_RATE_4MHZ,  spi::DATA_RATE_2MHZ, spi::DATA_RATE_1MHZ};
+
+  for (uint32_t rate : rates) {
+    if (rate < dataRate) {
+      return rate;
+    }
+  }
+
+  return 0;  // Nothing slower to try
+}
+
 void nRF905::updateConfig(Config *config, uint8_t *const pStatus) {
   this->_config = *config;
 
   this->writeConfigRegisters(pStatus);
 }
 
+void nRF905::writeChannelConfig(const uint16_t channel, const bool band, const int8_t txPower,
+                                uint8_t *const pStatus) {
+  this->_config.channel = channel;
+  this->_config.band = band;
+  this->_config.tx_power = txPower;
+  this->_config.frequency = ((422400000 + (channel * 100000)) * (band ? 2 : 1));  // internal
+
+  // Only registers 0 and 1 change, so this ends up as a single CHANNEL_CONFIG instruction
+  this->writeConfigRegisters(pStatus);
+}
+
 void nRF905::readConfigRegisters(uint8_t *const pStatus) {
-  Mode mode;
   ConfigBuffer buffer;
 
   // Set mode to idle
-  mode = this->_mode;
-  this->setMode(Idle);
+  this->standbyBegin();
 
   // Prepare data
   buffer.command = NRF905_COMMAND_R_CONFIG;
@@ -202,66 +474,119 @@ void nRF905::readConfigRegisters(uint8_t *const pStatus) {
   (void) memset(&this->_config, 0, sizeof(Config));
   this->decodeConfigRegisters(&buffer, &this->_config);
 
+  (void) memcpy(this->_configShadow, buffer.data, NRF905_REGISTER_COUNT);
+  this->_configShadowValid = true;
+
   // Restore mode
-  this->setMode(mode);
+  this->standbyEnd();
 }
 
 void nRF905::writeConfigRegisters(uint8_t *const pStatus) {
-  Mode mode;
+  ConfigBuffer encoded;
   ConfigBuffer buffer;
-#if CHECK_REG_WRITE
-  uint8_t writeData[NRF905_REGISTER_COUNT];
-#endif
+  uint8_t first = 0;
+  uint8_t last = NRF905_REGISTER_COUNT - 1;
+  uint8_t length;
 
-  mode = this->_mode;
-  this->setMode(Idle);
+  this->encodeConfigRegisters(&this->_config, &encoded);
+
+  // Only write the span of registers that differs from what is already in the chip
+  if (this->_configShadowValid) {
+    while ((first < NRF905_REGISTER_COUNT) && (encoded.data[first] == this->_configShadow[first])) {
+      ++first;
+    }
+    if (first == NRF905_REGISTER_COUNT) {
+      ESP_LOGV(TAG, "Config unchanged, skipping write");
+      if (pStatus != NULL) {
+        *pStatus = this->readStatus();
+      }
+      return;
+    }
+    while (encoded.data[last] == this->_configShadow[last]) {
+      --last;
+    }
+  }
+  length = last - first + 1;
+
+  this->standbyBegin();
 
   this->printConfig(&this->_config);
 
-  // Create data
-  buffer.command = NRF905_COMMAND_W_CONFIG;
-  this->encodeConfigRegisters(&this->_config, &buffer);
+  // Channel, band and TX power changes fit in the 2-byte CHANNEL_CONFIG instruction
+  if (this->_configShadowValid && (last <= 1) &&
+      (((encoded.data[1] ^ this->_configShadow[1]) & ~NRF905_CHANNEL_CONFIG_MASK) == 0)) {
+    this->writeChannelConfigCommand(encoded.data, pStatus);
 
-  ESP_LOGV(TAG, "Write config data: %s", hexArrayToStr(buffer.data, NRF905_REGISTER_COUNT));
-#if CHECK_REG_WRITE
-  (void) memcpy(writeData, buffer.data, NRF905_REGISTER_COUNT);
-#endif
+    this->standbyEnd();
+    return;
+  }
 
-  this->spiTransfer((uint8_t *) &buffer, sizeof(ConfigBuffer));
+  // W_CONFIG takes the register to start writing from in its lower nibble
+  buffer.command = NRF905_COMMAND_W_CONFIG | first;
+  (void) memcpy(buffer.data, &encoded.data[first], length);
+
+  ESP_LOGV(TAG, "Write config data @%u: %s", first, hexArrayToStr(buffer.data, length));
+
+  this->spiTransfer((uint8_t *) &buffer, 1 + length);
+
+  if (pStatus != NULL) {
+    *pStatus = buffer.command;
+  }
 
 #if CHECK_REG_WRITE
-  // Check config write by reading config back and compare
+  // Check config write by reading the written registers back and compare
   {
     ConfigBuffer bufferRead;
 
-    bufferRead.command = NRF905_COMMAND_R_CONFIG;
-    (void) memset(bufferRead.data, 0, NRF905_REGISTER_COUNT);
+    bufferRead.command = NRF905_COMMAND_R_CONFIG | first;
+    (void) memset(bufferRead.data, 0, length);
 
-    this->spiTransfer((uint8_t *) &bufferRead, sizeof(ConfigBuffer));
-    if (memcmp((void *) writeData, (void *) bufferRead.data, NRF905_REGISTER_COUNT) != 0) {
+    this->spiTransfer((uint8_t *) &bufferRead, 1 + length);
+    if (memcmp((void *) &encoded.data[first], (void *) bufferRead.data, length) != 0) {
       ESP_LOGE(TAG, "Configuration write verification failed");
+      // Contents unknown, do a full write next time
+      this->_configShadowValid = false;
     } else {
       ESP_LOGV(TAG, "Configuration write successful");
+      (void) memcpy(this->_configShadow, encoded.data, NRF905_REGISTER_COUNT);
+      this->_configShadowValid = true;
     }
   }
+#else
+  (void) memcpy(this->_configShadow, encoded.data, NRF905_REGISTER_COUNT);
+  this->_configShadowValid = true;
 #endif
 
+  // Restore mode
+  this->standbyEnd();
+}
+
+void nRF905::writeChannelConfigCommand(const uint8_t *const pData, uint8_t *const pStatus) {
+  uint8_t buffer[2];
+
+  // 1000pphc cccccccc: PA_PWR, HFREQ_PLL and CH_NO[8] are the low nibble of register 1, CH_NO[7:0] is register 0
+  buffer[0] = NRF905_COMMAND_CHANNEL_CONFIG | (pData[1] & NRF905_CHANNEL_CONFIG_MASK);
+  buffer[1] = pData[0];
+
+  ESP_LOGV(TAG, "Write channel config: 0x%02X 0x%02X", buffer[0], buffer[1]);
+
+  this->spiTransfer(buffer, sizeof(buffer));
+
+  this->_configShadow[0] = pData[0];
+  this->_configShadow[1] = (this->_configShadow[1] & ~NRF905_CHANNEL_CONFIG_MASK) |
+                           (pData[1] & NRF905_CHANNEL_CONFIG_MASK);
+
   if (pStatus != NULL) {
-    *pStatus = buffer.command;
+    *pStatus = buffer[0];
   }
-
-  // Restore mode
-  this->setMode(mode);
 }
 
 void nRF905::writeTxAddress(const uint32_t txAddress, uint8_t *const pStatus) {
-  Mode mode;
   AddressBuffer buffer;
 
   ESP_LOGD(TAG, "Set TX Address: 0x%08X", txAddress);
 
-  mode = this->_mode;
-  this->setMode(Idle);
+  this->standbyBegin();
 
   buffer.command = NRF905_COMMAND_W_TX_ADDRESS;
   buffer.address[3] = (txAddress >> 24) & 0xFF;
@@ -276,15 +601,13 @@ void nRF905::writeTxAddress(const uint32_t txAddress, uint8_t *const pStatus) {
   }
 
   // Restore mode
-  this->setMode(mode);
+  this->standbyEnd();
 }
 
 void nRF905::readTxAddress(uint32_t *pTxAddress, uint8_t *const pStatus) {
-  Mode mode;
   AddressBuffer buffer;
 
-  mode = this->_mode;
-  this->setMode(Idle);
+  this->standbyBegin();
 
   buffer.command = NRF905_COMMAND_R_TX_ADDRESS;
   (void) memset(buffer.address, 0, 4);
@@ -302,11 +625,10 @@ void nRF905::readTxAddress(uint32_t *pTxAddress, uint8_t *const pStatus) {
     *pStatus = buffer.command;
   }
 
-  this->setMode(mode);
+  this->standbyEnd();
 }
 
 void nRF905::readTxPayload(uint8_t *const pData, const uint8_t dataLength, uint8_t *const pStatus) {
-  Mode mode;
   Buffer buffer;
 
   if (pData == NULL) {
@@ -321,21 +643,22 @@ void nRF905::readTxPayload(uint8_t *const pData, const uint8_t dataLength, uint8
   buffer.command = NRF905_COMMAND_R_TX_PAYLOAD;
   (void) memset(buffer.payload, 0, NRF905_MAX_FRAMESIZE);
 
-  mode = this->_mode;
-  this->setMode(Idle);
+  this->standbyBegin();
 
   this->spiTransfer((uint8_t *) &buffer, sizeof(Buffer));
   (void) memcpy(pData, buffer.payload, dataLength);
 
+  (void) memcpy(this->_txPayloadShadow, buffer.payload, NRF905_MAX_FRAMESIZE);
+  this->_txPayloadShadowValid = true;
+
   if (pStatus != NULL) {
     *pStatus = buffer.command;
   }
 
-  this->setMode(mode);
+  this->standbyEnd();
 }
 
 void nRF905::writeTxPayload(const uint8_t *const pData, const uint8_t dataLength, uint8_t *const pStatus) {
-  Mode mode;
   Buffer buffer;
 
   if (pData == NULL) {
@@ -347,27 +670,38 @@ void nRF905::writeTxPayload(const uint8_t *const pData, const uint8_t dataLength
     return;
   }
 
-  ESP_LOGV(TAG, "Read config data: %s", hexArrayToStr(pData, dataLength));
-
   // Clear buffer payload
   (void) memset(buffer.payload, 0, NRF905_MAX_FRAMESIZE);
 
   buffer.command = NRF905_COMMAND_W_TX_PAYLOAD;
   (void) memcpy(buffer.payload, (uint8_t *) pData, dataLength);
 
-  mode = this->_mode;
-  this->setMode(Idle);
+  // Already loaded: no standby round trip and no bus traffic
+  if (this->_txPayloadShadowValid && (pStatus == NULL) &&
+      (memcmp(buffer.payload, this->_txPayloadShadow, NRF905_MAX_FRAMESIZE) == 0)) {
+    ESP_LOGV(TAG, "TX payload unchanged, not uploading");
+    ++this->_txPayloadSkips;
+    return;
+  }
+
+  ESP_LOGV(TAG, "Write TX payload: %s", hexArrayToStr(pData, dataLength));
+
+  // All 32 bytes are written, so the shadow covers any payload width; copied first, the transfer overwrites the buffer
+  (void) memcpy(this->_txPayloadShadow, buffer.payload, NRF905_MAX_FRAMESIZE);
+  this->_txPayloadShadowValid = true;
+
+  this->standbyBegin();
 
   this->spiTransfer((uint8_t *) &buffer, sizeof(Buffer));
   if (pStatus != NULL) {
     *pStatus = buffer.command;
   }
 
-  this->setMode(mode);
+  this->standbyEnd();
 }
 
 void nRF905::readRxPayload(uint8_t *const pData, const uint8_t dataLength, uint8_t *const pStatus) {
-  Buffer buffer;
+  uint8_t status;
 
   if (pData == NULL) {
     ESP_LOGE(TAG, "Read RX data pointer invalid");
@@ -378,16 +712,12 @@ void nRF905::readRxPayload(uint8_t *const pData, const uint8_t dataLength, uint8
     return;
   }
 
-  buffer.command = NRF905_COMMAND_R_RX_PAYLOAD;
-  (void) memset(buffer.payload, 0, NRF905_MAX_FRAMESIZE);
-
-  this->spiTransfer((uint8_t *) &buffer, sizeof(Buffer));
-
-  (void) memcpy(pData, buffer.payload, dataLength);
+  // Clock the payload straight into the caller's buffer
+  status = this->spiTransfer(NRF905_COMMAND_R_RX_PAYLOAD, pData, dataLength);
 
   // Return status if needed
   if (pStatus != NULL) {
-    *pStatus = buffer.command;
+    *pStatus = status;
   }
 }
 
@@ -533,32 +863,93 @@ bool nRF905::airwayBusy(void) {
 }
 
 void nRF905::startTx(const uint32_t retransmit, const Mode nextMode) {
-  bool update = false;
+  // Send the frame retransmit times (at least once); with the DR interrupt the copies after the first are sent by
+  // the chip itself
+  this->retransmitCounter = (retransmit > 1) ? (retransmit - 1) : 0;
+  this->nextMode = nextMode;
+
+  // Set or clear retransmit flag; the register write is skipped when the flag did not change. Without the DR
+  // interrupt nothing can stop the chip after the last copy in time, so the copies are then sent one by one
+  this->_config.auto_retransmit = (this->retransmitCounter > 0) && !this->_statusPolling;
+  this->writeConfigRegisters();
+
   if (this->_mode == PowerDown) {
     this->setMode(Idle);
-    delay(3);  // Delay is needed to the radio has time to power-up and see the standby/TX pins pulse
   }
 
-  // Update counters
-  // this->retransmitCounter = retransmit;
-  this->nextMode = nextMode;
-
-  // Set or clear retransmit flag
-  // if ((this->_config.auto_retransmit == false) && (retransmit > 0)) {
-  //   this->_config.auto_retransmit = true;
-  //   update = true;
-  // } else if ((this->_config.auto_retransmit == true) && (retransmit == 0)) {
-  this->_config.auto_retransmit = false;
-  update = true;
-  // }
-  if (update == true) {
-    this->writeConfigRegisters();
+  if (this->updateTransition() == PoweringUp) {
+    // The radio needs time to power up and see the standby/TX pins pulse; loop() starts the transmission once
+    // it is ready instead of blocking here
+    this->_txPending = true;
+    return;
   }
 
+  this->beginTx();
+}
+
+void nRF905::beginTx(void) {
   // Start transmit
+  this->_drEdges = 0;
+  this->_txCopies = 0;
+  this->_isrTx = !this->_statusPolling;
+  this->_txStartTime = micros();
   this->setMode(Transmit);
 }
 
+bool nRF905::txComplete(const uint8_t state) {
+  if (!this->_statusPolling) {
+    // DR rises at the end of every copy and drops again when the chip starts the next one
+    return ((this->_drEdges + 1) / 2) > this->retransmitCounter;
+  }
+
+  // Single copies, DR is set once each one is sent
+  return ((state & (1 << NRF905_STATUS_DR)) != 0) && (this->_txCopies >= this->retransmitCounter);
+}
+
+uint8_t nRF905::readStatusLines(void) {
+  uint8_t state = 0;
+
+  if (this->_gpio_pin_am != NULL) {
+    // Both lines available, no need to touch the SPI bus
+    if (this->_gpio_pin_dr->digital_read()) {
+      state |= (1 << NRF905_STATUS_DR);
+    }
+    if (this->_gpio_pin_am->digital_read()) {
+      state |= (1 << NRF905_STATUS_AM);
+    }
+  } else {
+    // Only DR is wired; AM is needed to tell RX complete from TX ready, so fetch it from the status register
+    state = this->readStatus() & ((1 << NRF905_STATUS_DR) | (1 << NRF905_STATUS_AM));
+  }
+
+  return state;
+}
+
+void IRAM_ATTR nRF905::statusLineIsr(nRF905 *arg) { arg->_statusEdge = true; }
+
+void IRAM_ATTR nRF905::dataReadyIsr(nRF905 *arg) {
+  const uint32_t edges = arg->_drEdges + 1;
+
+  arg->_drEdges = edges;
+
+  // End the transmission here rather than in the loop, which may come round only several copies later
+  if (arg->_isrTx) {
+    if ((arg->retransmitCounter > 0) && (edges == (2 * arg->retransmitCounter))) {
+      // Last copy started; with CE low the chip finishes it and then goes to standby
+      arg->_isr_pin_ce.digital_write(false);
+    } else if (edges == ((2 * arg->retransmitCounter) + 1)) {
+      // Last copy sent; open the receive window right away, the reply may follow within a few ms
+      arg->_isrTx = false;
+      if (arg->nextMode == Receive) {
+        arg->_isr_pin_txen.digital_write(false);
+        arg->_isr_pin_ce.digital_write(true);
+      }
+    }
+  }
+
+  arg->_statusEdge = true;
+}
+
 uint8_t nRF905::readStatus(void) {
   uint8_t status = 0;
 
@@ -577,6 +968,19 @@ void nRF905::spiTransfer(uint8_t *const data, const size_t length) {
   this->disable();
 }
 
+uint8_t nRF905::spiTransfer(const uint8_t command, uint8_t *const data, const size_t length) {
+  uint8_t status = command;
+
+  this->enable();
+
+  this->transfer_array(&status, 1);
+  this->transfer_array(data, length);
+
+  this->disable();
+
+  return status;
+}
+
 char *nRF905::hexArrayToStr(const uint8_t *const pData, const size_t dataLength) {
   static char buf[256];
   size_t bufIdx = 0;
@@ -6,6 +6,9 @@
 #include "esphome/core/helpers.h"
 #include "esphome/components/spi/spi.h"
 #include "nRF905.h"
+#include "nRF905Delegate.h"
+
+#include <atomic>
 
 namespace esphome {
 namespace nrf905 {
@@ -13,10 +16,18 @@ namespace nrf905 {
 #define MAX_TRANSMIT_TIME 2000      // TODO figure out what timeout we want
 #define CARRIERDETECT_LED_DELAY 20  // On-board LED will light up for 20ms when data is received
 
+/* nRF905 mode switching times (us) */
+#define NRF905_POWERUP_TIME 3000  // Power down -> standby
+#define NRF905_SETTLE_TIME 650    // Standby -> TX or RX
+#define NRF905_CE_PULSE 10        // Minimum CE low time to start another transmission
+
 /* nRF905 register sizes */
 #define NRF905_REGISTER_COUNT 10
 #define NRF905_MAX_FRAMESIZE 32
 
+/* Received frame queue size, must be a power of 2 */
+#define NRF905_RX_QUEUE_SIZE 8
+
 /* nRF905 Instructions */
 #define NRF905_COMMAND_NOP 0xFF
 #define NRF905_COMMAND_W_CONFIG 0x00
@@ -28,6 +39,9 @@ namespace nrf905 {
 #define NRF905_COMMAND_R_RX_PAYLOAD 0x24
 #define NRF905_COMMAND_CHANNEL_CONFIG 0x80
 
+// Config register 1 bits covered by NRF905_COMMAND_CHANNEL_CONFIG (CH_NO[8], HFREQ_PLL, PA_PWR)
+#define NRF905_CHANNEL_CONFIG_MASK 0x0F
+
 // Bit positions
 #define NRF905_STATUS_DR 5
 #define NRF905_STATUS_AM 7
@@ -39,6 +53,9 @@ typedef enum {
 
 typedef enum { PowerDown, Idle, Receive, Transmit } Mode;
 
+// Transition the radio is going through after a mode change
+typedef enum { Settled, PoweringUp, TxSettling, RxSettling } Transition;
+
 typedef enum {
   ClkOut4000000 = 0x00,
   ClkOut2000000 = 0x01,
@@ -83,8 +100,14 @@ typedef struct {
   uint8_t payload[NRF905_MAX_FRAMESIZE];
 } Buffer;
 
-typedef std::function<void(void)> TxReadyCalllback;
-typedef std::function<void(const uint8_t *const pBuffer, const uint8_t size)> RxCompleteCallback;
+typedef struct {
+  uint32_t timestamp;  // millis() at the time the frame was read from the chip
+  uint8_t length;
+  uint8_t data[NRF905_MAX_FRAMESIZE];
+} RxFrame;
+
+typedef Delegate<void(void)> TxReadyCalllback;
+typedef Delegate<void(const uint8_t *const pBuffer, const uint8_t size)> RxCompleteCallback;
 
 class nRF905 : public Component,
                public spi::SPIDevice<spi::BIT_ORDER_MSB_FIRST, spi::CLOCK_POLARITY_LOW, spi::CLOCK_PHASE_LEADING,
@@ -100,27 +123,49 @@ class nRF905 : public Component,
   void dump_config() override;
   void loop() override;
 
-  void set_am_pin(GPIOPin *const pin) { _gpio_pin_am = pin; }
+  // Run the driver from another task instead of the ESPHome loop; that task then calls service()
+  void setServicedExternally(const bool external) { _servicedExternally = external; }
+  void service(void);
+
+  void set_am_pin(InternalGPIOPin *const pin) { _gpio_pin_am = pin; }
   void set_cd_pin(GPIOPin *const pin) { _gpio_pin_cd = pin; }
-  void set_ce_pin(GPIOPin *const pin) { _gpio_pin_ce = pin; }
-  void set_dr_pin(GPIOPin *const pin) { _gpio_pin_dr = pin; }
+  void set_ce_pin(InternalGPIOPin *const pin) { _gpio_pin_ce = pin; }
+  void set_dr_pin(InternalGPIOPin *const pin) { _gpio_pin_dr = pin; }
   void set_pwr_pin(GPIOPin *const pin) { _gpio_pin_pwr = pin; }
-  void set_txen_pin(GPIOPin *const pin) { _gpio_pin_txen = pin; }
+  void set_txen_pin(InternalGPIOPin *const pin) { _gpio_pin_txen = pin; }
 
+  // Called from the radio side for every received frame; it drains the RX queue, so do not use readRxFrame() too
   void setOnRxComplete(RxCompleteCallback callback) { onRxComplete = callback; }
+
+  // Received frames are queued until the consumer reads them, or the RX complete callback is given them
+  bool readRxFrame(RxFrame *const pFrame);
+  uint32_t getRxOverflowCount(void) { return this->_rxOverflows; }
+  uint8_t getRxHighWaterMark(void) { return this->_rxHighWater; }
+  uint8_t getRxPending(void) {
+    return this->_rxHead.load(std::memory_order_acquire) - this->_rxTail.load(std::memory_order_acquire);
+  }
   void setOnTxReady(TxReadyCalllback callback) { onTxReady = callback; }
 
   Mode getMode(void) { return this->_mode; };
   void setMode(const Mode mode);
+  Transition getTransition(void) { return this->updateTransition(); }
+  uint64_t getModeTime(const Mode mode);
+
+  // Group register accesses, so the radio switches to standby once for the whole batch
+  void beginBatch(void);
+  void endBatch(void);
 
   Config getConfig(void) { return this->_config; }
   void updateConfig(Config *config, uint8_t *const pStatus = NULL);
+  void writeChannelConfig(const uint16_t channel, const bool band, const int8_t txPower, uint8_t *const pStatus = NULL);
 
   void writeTxAddress(const uint32_t txAddress, uint8_t *const pStatus = NULL);
   void readTxAddress(uint32_t *const pTxAddress, uint8_t *const pStatus = NULL);
 
+  // Skipped when the chip already holds this payload, unless the status is asked for
   void writeTxPayload(const uint8_t *const pData, const uint8_t dataLength, uint8_t *const pStatus = NULL);
   void readTxPayload(uint8_t *const pData, const uint8_t dataLength, uint8_t *const pStatus = NULL);
+  uint32_t getTxPayloadSkipCount(void) { return this->_txPayloadSkips; }
 
   bool airwayBusy(void);
 
@@ -133,32 +178,92 @@ class nRF905 : public Component,
 
   void readConfigRegisters(uint8_t *const pStatus = NULL);
   void writeConfigRegisters(uint8_t *const pStatus = NULL);
+  void writeChannelConfigCommand(const uint8_t *const pData, uint8_t *const pStatus = NULL);
 
   void decodeConfigRegisters(const ConfigBuffer *const pBuffer, Config *const pConfig);
   void encodeConfigRegisters(const Config *const pConfig, ConfigBuffer *const pBuffer);
 
   uint8_t readStatus(void);
+  uint8_t readStatusLines(void);
+
+  static void statusLineIsr(nRF905 *arg);
+  static void dataReadyIsr(nRF905 *arg);
+
+  Transition updateTransition(void);
+  void beginTx(void);
+  bool txComplete(const uint8_t state);
 
   void spiTransfer(uint8_t *const data, const size_t length);
+  uint8_t spiTransfer(const uint8_t command, uint8_t *const data, const size_t length);
+
+  bool spiSelfTest(void);
+  uint32_t lowerDataRate(const uint32_t dataRate);
+
+  void standbyBegin(void);
+  void standbyEnd(void);
 
   char *hexArrayToStr(const uint8_t *const pData, const size_t dataLength);
 
   RxCompleteCallback onRxComplete{NULL};
 
-  uint32_t retransmitCounter{0};
+  uint32_t retransmitCounter{0};  // Copies to send after the first one
+  uint32_t _txStartTime{0};
   Mode nextMode{PowerDown};
   TxReadyCalllback onTxReady{NULL};
 
-  GPIOPin *_gpio_pin_am{NULL};
+  InternalGPIOPin *_gpio_pin_am{NULL};
   GPIOPin *_gpio_pin_cd{NULL};
-  GPIOPin *_gpio_pin_ce{NULL};
-  GPIOPin *_gpio_pin_dr{NULL};
+  InternalGPIOPin *_gpio_pin_ce{NULL};
+  InternalGPIOPin *_gpio_pin_dr{NULL};
   GPIOPin *_gpio_pin_pwr{NULL};
-  GPIOPin *_gpio_pin_txen{NULL};
+  InternalGPIOPin *_gpio_pin_txen{NULL};
+  // CE and TXEN as driven from the DR interrupt
+  ISRInternalGPIOPin _isr_pin_ce;
+  ISRInternalGPIOPin _isr_pin_txen;
 
   Mode _mode{PowerDown};
+  Transition _transition{Settled};
+  uint32_t _settledAt{0};  // micros() timestamp at which the current transition is done
+  // Mode time accounting; written by whoever drives the radio (possibly the RF task), read from the main loop. The
+  // sequence is odd while an update is in progress, so a reader retries instead of seeing a torn 64 bit value
+  std::atomic<uint32_t> _modeTimeSeq{0};
+  Mode _modeTimeMode{PowerDown};  // Mode the current stretch is counted for
+  uint32_t _modeSince{0};         // millis() timestamp of the last mode change
+  uint64_t _modeTime[Transmit + 1]{};  // Time spent in each mode (ms), excluding the current stretch
+  bool _txPending{false};  // startTx() called while powering up, transmit once settled
+
+  // DR/AM edge flag, set from the pin interrupt. Only used when the DR pin is available, otherwise the status
+  // register is polled over SPI on every loop.
+  volatile bool _statusEdge{false};
+  volatile uint32_t _drEdges{0};  // DR edges since the start of the current transmission
+  volatile bool _isrTx{false};    // DR interrupt ends the current transmission and opens the RX window
+  uint32_t _txCopies{0};          // Copies sent so far when polling, each one started by a CE pulse
+  bool _statusPolling{true};
+  uint8_t _lastState{0x00};  // DR/AM as seen by the previous loop()
+  bool _addrMatch{false};
 
   Config _config;
+
+  uint8_t _standbyDepth{0};
+  Mode _standbyMode{PowerDown};  // Mode to return to after the register accesses
+
+  bool _servicedExternally{false};
+
+  // Single producer (loop) / single consumer (readRxFrame) received frame ring
+  RxFrame _rxQueue[NRF905_RX_QUEUE_SIZE];
+  std::atomic<uint8_t> _rxHead{0};
+  std::atomic<uint8_t> _rxTail{0};
+  uint32_t _rxOverflows{0};
+  uint8_t _rxHighWater{0};
+
+  // Last register contents known to be in the chip, so config updates only write the bytes that changed
+  uint8_t _configShadow[NRF905_REGISTER_COUNT];
+  bool _configShadowValid{false};
+
+  // TX payload register contents, so uploading the frame that is already loaded (retries, repeated polls) is skipped
+  uint8_t _txPayloadShadow[NRF905_MAX_FRAMESIZE];
+  bool _txPayloadShadowValid{false};
+  uint32_t _txPayloadSkips{0};
 };
 
 }  // namespace nrf905
@@ -0,0 +1,48 @@
+#ifndef __COMPONENT_nRF905_DELEGATE_H__
+#define __COMPONENT_nRF905_DELEGATE_H__
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace esphome {
+namespace nrf905 {
+
+// Callback holding its callable inline, so setting or calling it never touches the heap (unlike std::function).
+// Takes small, trivially copyable callables only: plain functions and lambdas capturing a pointer or two.
+template<typename Signature> class Delegate;
+
+template<typename R, typename... Args> class Delegate<R(Args...)> {
+ public:
+  static const size_t CAPACITY = 2 * sizeof(void *);
+
+  Delegate() {}
+  Delegate(std::nullptr_t) {}
+
+  // Integral types excluded so NULL lands on the nullptr_t constructor
+  template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Delegate>::value &&
+                                                          !std::is_integral<F>::value>::type>
+  Delegate(F f) {
+    static_assert(sizeof(F) <= CAPACITY, "Callable too large for a Delegate, capture less");
+    static_assert(std::is_trivially_copyable<F>::value && std::is_trivially_destructible<F>::value,
+                  "Delegate callables must be trivially copyable");
+
+    new (this->storage_) F(f);
+    this->invoke_ = [](const void *pStorage, Args... args) -> R { return (*(const F *) pStorage)(args...); };
+  }
+
+  R operator()(Args... args) const { return this->invoke_(this->storage_, args...); }
+
+  explicit operator bool() const { return this->invoke_ != nullptr; }
+  bool operator==(std::nullptr_t) const { return this->invoke_ == nullptr; }
+  bool operator!=(std::nullptr_t) const { return this->invoke_ != nullptr; }
+
+ protected:
+  alignas(void *) unsigned char storage_[CAPACITY]{};
+  R (*invoke_)(const void *pStorage, Args... args){nullptr};
+};
+
+}  // namespace nrf905
+}  // namespace esphome
+
+#endif /* __COMPONENT_nRF905_DELEGATE_H__ */
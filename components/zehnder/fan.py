@@ -1,22 +1,81 @@
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome.components import fan
+from esphome.components import esp32, fan
+from esphome.components.esp32.const import VARIANT_ESP32, VARIANT_ESP32P4, VARIANT_ESP32S3
 from esphome.const import CONF_ID, CONF_UPDATE_INTERVAL
+from esphome.core import CORE
 
-from esphome.components.nrf905 import nRF905Component
+from esphome.components.nrf905 import nRF905Component, nrf905_ns
 from . import zehnder_ns, ZehnderRF
 
 
 DEPENDENCIES = ["nrf905"]
 
 CONF_NRF905 = "nrf905"
+CONF_RADIO_IDLE_MODE = "radio_idle_mode"
+CONF_COMMAND_MAX_AGE = "command_max_age"
+CONF_PASSIVE_TRACKING = "passive_tracking"
+CONF_MIN_UPDATE_INTERVAL = "min_update_interval"
+CONF_MAX_UPDATE_INTERVAL = "max_update_interval"
+CONF_PUBLISH_MIN_INTERVAL = "publish_min_interval"
+CONF_PUBLISH_HEARTBEAT = "publish_heartbeat"
+CONF_RF_TASK = "rf_task"
+CONF_RF_TASK_CORE = "rf_task_core"
 
-CONFIG_SCHEMA = fan.fan_schema(ZehnderRF).extend(
+Mode = nrf905_ns.enum("Mode")
+RADIO_IDLE_MODES = {
+    "RECEIVE": Mode.Receive,
+    "STANDBY": Mode.Idle,
+    "POWER_DOWN": Mode.PowerDown,
+}
+
+# The other variants (C2, C3, C5, C6, H2, S2) only have core 0
+DUAL_CORE_VARIANTS = [VARIANT_ESP32, VARIANT_ESP32S3, VARIANT_ESP32P4]
+
+
+def validate_update_intervals(config):
+    if config[CONF_MIN_UPDATE_INTERVAL] > config[CONF_MAX_UPDATE_INTERVAL]:
+        raise cv.Invalid(f"{CONF_MIN_UPDATE_INTERVAL} must not be larger than {CONF_MAX_UPDATE_INTERVAL}")
+    return config
+
+
+def validate_passive_tracking(config):
+    # Frames for other devices are only heard while the radio listens between polls
+    if config[CONF_PASSIVE_TRACKING] and config[CONF_RADIO_IDLE_MODE] != "RECEIVE":
+        raise cv.Invalid(f"{CONF_PASSIVE_TRACKING} needs {CONF_RADIO_IDLE_MODE} RECEIVE")
+    return config
+
+
+def validate_rf_task(config):
+    if config[CONF_RF_TASK] and not CORE.is_esp32:
+        raise cv.Invalid(f"{CONF_RF_TASK} is only available on ESP32")
+    cores = 2 if CORE.is_esp32 and esp32.get_esp32_variant() in DUAL_CORE_VARIANTS else 1
+    if CONF_RF_TASK_CORE not in config:
+        # Away from core 0, where Wi-Fi runs, when there is a second core
+        config[CONF_RF_TASK_CORE] = cores - 1
+    elif config[CONF_RF_TASK_CORE] >= cores:
+        raise cv.Invalid(f"{CONF_RF_TASK_CORE} must be 0 on this single core ESP32 variant", path=[CONF_RF_TASK_CORE])
+    return config
+
+
+CONFIG_SCHEMA = cv.All(fan.fan_schema(ZehnderRF).extend(
     {
         cv.Required(CONF_NRF905): cv.use_id(nRF905Component),
         cv.Optional(CONF_UPDATE_INTERVAL, default="30s"): cv.update_interval,
+        # Polling speeds up to the minimum after a command and backs off to the maximum while nothing changes
+        cv.Optional(CONF_MIN_UPDATE_INTERVAL, default="10s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_MAX_UPDATE_INTERVAL, default="5min"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_RADIO_IDLE_MODE, default="RECEIVE"): cv.enum(RADIO_IDLE_MODES, upper=True),
+        cv.Optional(CONF_COMMAND_MAX_AGE, default="10s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_PASSIVE_TRACKING, default=False): cv.boolean,
+        # State is only published when it changes; 0s publishes every change at once and never repeats it
+        cv.Optional(CONF_PUBLISH_MIN_INTERVAL, default="0s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_PUBLISH_HEARTBEAT, default="0s"): cv.positive_time_period_milliseconds,
+        # Radio and retries in their own task pinned to a core, away from Wi-Fi, API and logging in the main loop
+        cv.Optional(CONF_RF_TASK, default=False): cv.boolean,
+        cv.Optional(CONF_RF_TASK_CORE): cv.int_range(min=0, max=1),
     }
-).extend(cv.COMPONENT_SCHEMA)
+).extend(cv.COMPONENT_SCHEMA), validate_update_intervals, validate_passive_tracking, validate_rf_task)
 
 
 async def to_code(config):
@@ -28,3 +87,12 @@ async def to_code(config):
     cg.add(var.set_rf(nrf905))
 
     cg.add(var.set_update_interval(config[CONF_UPDATE_INTERVAL]))
+    cg.add(var.set_update_interval_min(config[CONF_MIN_UPDATE_INTERVAL]))
+    cg.add(var.set_update_interval_max(config[CONF_MAX_UPDATE_INTERVAL]))
+    cg.add(var.set_radio_idle_mode(config[CONF_RADIO_IDLE_MODE]))
+    cg.add(var.set_command_max_age(config[CONF_COMMAND_MAX_AGE]))
+    cg.add(var.set_passive_tracking(config[CONF_PASSIVE_TRACKING]))
+    cg.add(var.set_publish_min_interval(config[CONF_PUBLISH_MIN_INTERVAL]))
+    cg.add(var.set_publish_heartbeat(config[CONF_PUBLISH_HEARTBEAT]))
+    cg.add(var.set_rf_task(config[CONF_RF_TASK]))
+    cg.add(var.set_rf_task_core(config[CONF_RF_TASK_CORE]))
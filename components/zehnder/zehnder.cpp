@@ -9,53 +9,6 @@ namespace zehnder {
 
 static const char *const TAG = "zehnder";
 
-typedef struct __attribute__((packed)) {
-  uint32_t networkId;
-} RfPayloadNetworkJoinOpen;
-
-typedef struct __attribute__((packed)) {
-  uint32_t networkId;
-} RfPayloadNetworkJoinRequest;
-
-typedef struct __attribute__((packed)) {
-  uint32_t networkId;
-} RfPayloadNetworkJoinAck;
-
-typedef struct __attribute__((packed)) {
-  uint8_t speed;
-  uint8_t voltage;
-  uint8_t timer;
-} RfPayloadFanSettings;
-
-typedef struct __attribute__((packed)) {
-  uint8_t speed;
-} RfPayloadFanSetSpeed;
-
-typedef struct __attribute__((packed)) {
-  uint8_t speed;
-  uint8_t timer;
-} RfPayloadFanSetTimer;
-
-typedef struct __attribute__((packed)) {
-  uint8_t rx_type;          // 0x00 RX Type
-  uint8_t rx_id;            // 0x01 RX ID
-  uint8_t tx_type;          // 0x02 TX Type
-  uint8_t tx_id;            // 0x03 TX ID
-  uint8_t ttl;              // 0x04 Time-To-Live
-  uint8_t command;          // 0x05 Frame type
-  uint8_t parameter_count;  // 0x06 Number of parameters
-
-  union {
-    uint8_t parameters[9];                           // 0x07 - 0x0F Depends on command
-    RfPayloadFanSetSpeed setSpeed;                   // Command 0x02
-    RfPayloadFanSetTimer setTimer;                   // Command 0x03
-    RfPayloadNetworkJoinRequest networkJoinRequest;  // Command 0x04
-    RfPayloadNetworkJoinOpen networkJoinOpen;        // Command 0x06
-    RfPayloadFanSettings fanSettings;                // Command 0x07
-    RfPayloadNetworkJoinAck networkJoinAck;          // Command 0x0C
-  } payload;
-} RfFrame;
-
 static uint8_t minmax(const uint8_t value, const uint8_t min, const uint8_t max) {
   if (value <= min) {
     return min;
@@ -81,6 +34,16 @@ static int clamp_voltage(const int value) {
   }
 }
 
+static int clamp_speed(const int value, const int max) {
+  // Speed comes straight from the frame; a corrupted one must not report a preset the fan does not have
+  if (value > max) {
+    ESP_LOGW(TAG, "Invalid speed value %i clamped to %i", value, max);
+    return max;
+  } else {
+    return value;
+  }
+}
+
 ZehnderRF::ZehnderRF(void) {}
 
 fan::FanTraits ZehnderRF::get_traits() { return fan::FanTraits(false, true, false, this->speed_count_); }
@@ -95,19 +58,11 @@ void ZehnderRF::control(const fan::FanCall &call) {
     ESP_LOGD(TAG, "Fan control speed changed: %u", this->speed);
   }
 
-  switch (this->state_) {
-    case StateIdle:
-      // Set speed
-      this->setSpeed(this->state ? this->speed : 0x00, 0);
+  // Set speed
+  this->setSpeed(this->state ? this->speed : 0x00, 0);
 
-      this->lastFanQuery_ = millis();  // Update time
-      break;
-
-    default:
-      break;
-  }
-
-  this->publish_state();
+  // Acknowledge the user right away, whatever the rate limit
+  this->publishSettings(true);
 }
 
 void ZehnderRF::setup() {
@@ -161,32 +116,74 @@ void ZehnderRF::setup() {
   this->rf_->setOnTxReady([this](void) {
     ESP_LOGD(TAG, "TX ready");
     if (this->rfState_ == RfStateTxBusy) {
+      this->rfTxDoneAt_ = millis();
       if (this->retries_ >= 0) {
         this->msgSendTime_ = millis();
         this->rfState_ = RfStateRxWait;
       } else {
         this->rfState_ = RfStateIdle;
+        this->rfEvent(RfEventDone);
       }
     }
   });
 
-  this->rf_->setOnRxComplete([this](const uint8_t *const pData, const uint8_t dataLength) {
-    ESP_LOGV(TAG, "RF frame received, length: %u bytes", dataLength);
-    this->rfHandleReceived(pData, dataLength);
-  });
+#ifdef USE_ESP32
+  // Radio and retries in a task of their own, so reply windows do not depend on how busy the main loop is
+  if (this->rfTask_) {
+    // Pinning to a core the chip does not have trips a FreeRTOS assert
+    if (this->rfTaskCore_ >= portNUM_PROCESSORS) {
+      this->rfTaskCore_ = 0;
+    }
+    this->rf_->setServicedExternally(true);
+    if (xTaskCreatePinnedToCore(ZehnderRF::rfTaskEntry, "zehnder_rf", FAN_RF_TASK_STACK, this, FAN_RF_TASK_PRIORITY,
+                                &this->rfTaskHandle_, this->rfTaskCore_) != pdPASS) {
+      ESP_LOGE(TAG, "Could not start the RF task, running from the main loop");
+      this->rf_->setServicedExternally(false);
+      this->rfTask_ = false;
+    }
+  }
+#endif
 }
 
 void ZehnderRF::dump_config(void) {
   ESP_LOGCONFIG(TAG, "Zehnder Fan config:");
-  ESP_LOGCONFIG(TAG, "  Polling interval   %u", this->interval_);
+  ESP_LOGCONFIG(TAG, "  Polling interval   %u ms (%u - %u ms)", this->interval_, this->intervalMin_,
+                this->intervalMax_);
+  ESP_LOGCONFIG(TAG, "  Radio idle mode    %s",
+                this->radioIdleMode_ == nrf905::PowerDown ? "power down"
+                : this->radioIdleMode_ == nrf905::Idle    ? "standby"
+                                                          : "receive");
+  ESP_LOGCONFIG(TAG, "  Command max age    %u ms", this->commandMaxAge_);
+  ESP_LOGCONFIG(TAG, "  Passive tracking   %s", this->passiveTracking_ ? "yes" : "no");
+  ESP_LOGCONFIG(TAG, "  Publish interval   %u ms minimum, heartbeat %u ms", this->publishMinInterval_,
+                this->publishHeartbeat_);
+  ESP_LOGCONFIG(TAG, "  RF engine          %s (core %u)", this->rfTask_ ? "own task" : "main loop", this->rfTaskCore_);
+  ESP_LOGCONFIG(TAG, "  Reply timeout      %u - %u ms, retry backoff %u - %u ms", FAN_REPLY_TIMEOUT_MIN,
+                FAN_REPLY_TIMEOUT, FAN_RETRY_BACKOFF, FAN_RETRY_BACKOFF_MAX);
   ESP_LOGCONFIG(TAG, "  Fan networkId      0x%08X", this->config_.fan_networkId);
   ESP_LOGCONFIG(TAG, "  Fan my device type 0x%02X", this->config_.fan_my_device_type);
   ESP_LOGCONFIG(TAG, "  Fan my device id   0x%02X", this->config_.fan_my_device_id);
   ESP_LOGCONFIG(TAG, "  Fan main_unit type 0x%02X", this->config_.fan_main_unit_type);
   ESP_LOGCONFIG(TAG, "  Fan main unit id   0x%02X", this->config_.fan_main_unit_id);
   ESP_LOGCONFIG(TAG, "Connection Status Sensor:");
-  ESP_LOGCONFIG(TAG, "  Health timeout     %u ms", this->interval_ * 5);
+  ESP_LOGCONFIG(TAG, "  Health timeout     5x the current polling interval");
   ESP_LOGCONFIG(TAG, "  Failure threshold  3 consecutive timeouts");
+  this->dumpLatency("Speed command", CommandSetSpeed);
+  this->dumpLatency("Poll", CommandQuery);
+}
+
+void ZehnderRF::dumpLatency(const char *const name, const CommandType type) {
+  static const char *const stageNames[LatencyNrOf] = {"Wait", "Transmit", "Reply", "Confirm", "Total"};
+  const LatencyHistogram *const pHistograms = this->latency_[type];
+
+  ESP_LOGCONFIG(TAG, "%s latency (%u completed), p50 / p95 / p99 ms:", name, pHistograms[LatencyTotal].count());
+  for (uint8_t stage = 0; stage < LatencyNrOf; ++stage) {
+    if ((stage == LatencyConfirm) && (type != CommandSetSpeed)) {
+      continue;
+    }
+    ESP_LOGCONFIG(TAG, "  %-18s %u / %u / %u", stageNames[stage], pHistograms[stage].percentile(50),
+                  pHistograms[stage].percentile(95), pHistograms[stage].percentile(99));
+  }
 }
 
 void ZehnderRF::set_config(const uint32_t fan_networkId,
@@ -201,14 +198,45 @@ void ZehnderRF::set_config(const uint32_t fan_networkId,
   this->config_.fan_main_unit_id   = fan_main_unit_id;   // Fan (Zehnder/BUVA) main unit ID
   ESP_LOGD(TAG, "Saving pairing configuration");
   this->pref_.save(&this->config_);
+
+  this->buildFrameTemplates();
 }
 
 void ZehnderRF::loop(void) {
   uint8_t deviceId;
-  nrf905::Config rfConfig;
+  nrf905::RxFrame frame;
 
-  // Run RF handler
-  this->rfHandler();
+  // Handle frames queued by the radio since the last loop
+  while (this->rf_->readRxFrame(&frame)) {
+    ESP_LOGV(TAG, "RF frame received, length: %u bytes, %u ms ago", frame.length, millis() - frame.timestamp);
+    this->rxTimestamp_ = frame.timestamp;
+    this->rfHandleReceived(frame.data, frame.length);
+  }
+
+  // A user command preempts a poll that is not on air, i.e. before its first attempt or between retries; a command
+  // is answered with the fan settings as well
+  if ((this->state_ == StateWaitQueryResponse) && this->rfBusy_ &&
+      ((this->rfState_ == RfStateWaitAirwayFree) || (this->rfState_ == RfStateIdle)) && this->userCommandPending()) {
+    ESP_LOGD(TAG, "Poll preempted by user command");
+    this->rfCancel();
+    this->state_ = StateIdle;
+
+    this->processCommands();
+  }
+
+  // Run the RF engine, unless it has a task of its own
+  if (!this->rfTask_) {
+    this->rfTaskStep();
+  }
+  this->rfHandleEvents();
+
+  // Rate limited change, or a heartbeat for consumers that want to see the state every now and then
+  if (this->publishPending_ && ((millis() - this->lastPublish_) >= this->publishMinInterval_)) {
+    this->publishSettings(false);
+  } else if ((this->publishHeartbeat_ != 0) && this->published_.valid &&
+             ((millis() - this->lastPublish_) >= this->publishHeartbeat_)) {
+    this->publishSettings(true);
+  }
 
   switch (this->state_) {
     case StateStartup:
@@ -224,10 +252,9 @@ void ZehnderRF::loop(void) {
         } else {
           ESP_LOGD(TAG, "Configuration data valid, starting polling");
 
-          rfConfig = this->rf_->getConfig();
-          rfConfig.rx_address = this->config_.fan_networkId;
-          this->rf_->updateConfig(&rfConfig);
-          this->rf_->writeTxAddress(this->config_.fan_networkId);
+          this->rfSetAddress(this->config_.fan_networkId);
+
+          this->buildFrameTemplates();
 
           ESP_LOGD(TAG, "RF network configured, starting device query");
           // Start with query
@@ -244,21 +271,26 @@ void ZehnderRF::loop(void) {
       break;
 
     case StateIdle:
-      if (newSetting == true) {
-        this->setSpeed(newSpeed, newTimer);
-      } else {
-        if ((millis() - this->lastFanQuery_) > this->interval_) {
-          this->queryDevice();
-        }
+      if ((millis() - this->lastFanQuery_) > this->pollDelay_) {
+        this->queueCommand(CommandQuery, 0, 0, this->pollDelay_);
+      }
+      this->processCommands();
+
+      // Nothing to wait for until the next poll, so stop listening if configured to save power
+      if ((this->state_ == StateIdle) && !this->rfBusy_ && (this->radioIdleMode_ != nrf905::Receive) &&
+          !this->radioIdle_) {
+        ESP_LOGV(TAG, "Reply window closed, radio to low power mode");
+        this->rfSetIdleMode(this->radioIdleMode_);
       }
-      
+
       // Periodic health check - if no successful communication for too long, mark as unhealthy
       this->check_connection_health();
       break;
 
     case StateWaitSetSpeedConfirm:
-      if (this->rfState_ == RfStateIdle) {
+      if (!this->rfBusy_) {
         // When done, return to idle
+        this->latencyFinish();
         this->state_ = StateIdle;
       }
 
@@ -268,45 +300,64 @@ void ZehnderRF::loop(void) {
 }
 
 void ZehnderRF::rfHandleReceived(const uint8_t *const pData, const uint8_t dataLength) {
-  const RfFrame *const pResponse = (RfFrame *) pData;
-  RfFrame *const pTxFrame = (RfFrame *) this->_txFrame;  // frame helper
-  nrf905::Config rfConfig;
+  RfFrame frame;
+  RfPayloadNetworkJoinOpen joinOpen;
+  RfPayloadFanSettings settings;
+
+  switch (rfFrameDecode(pData, dataLength, &frame)) {
+    case RfFrameTooShort:
+      ESP_LOGW(TAG, "Received frame too short (%u bytes), ignoring", dataLength);
+      return;
+
+    case RfFrameBadParameterCount:
+      ESP_LOGW(TAG, "Received frame type 0x%02X with %u parameters, ignoring", frame.command, frame.parameter_count);
+      return;
+
+    default:
+      break;
+  }
+
+  if (this->rfIsDuplicate(frame)) {
+    ESP_LOGV(TAG, "Repeated frame type 0x%02X from ID 0x%02X, ignoring", frame.command, frame.tx_id);
+    return;
+  }
 
   ESP_LOGD(TAG, "Current state: 0x%02X", this->state_);
+
+  if (this->trackFanSettings(frame)) {
+    return;
+  }
+
   switch (this->state_) {
     case StateDiscoveryWaitForLinkRequest:
       ESP_LOGD(TAG, "Discovery state: waiting for link request");
-      switch (pResponse->command) {
+      switch (frame.command) {
         case FAN_NETWORK_JOIN_OPEN:  // Received linking request from main unit
-          ESP_LOGD(TAG, "Discovery: Found unit type 0x%02X (%s) with ID 0x%02X on network 0x%08X", pResponse->tx_type,
-                   pResponse->tx_type == FAN_TYPE_MAIN_UNIT ? "Main" : "?", pResponse->tx_id,
-                   pResponse->payload.networkJoinOpen.networkId);
+          joinOpen = frame.payload<RfPayloadNetworkJoinOpen>();
+          ESP_LOGD(TAG, "Discovery: Found unit type 0x%02X (%s) with ID 0x%02X on network 0x%08X", frame.tx_type,
+                   frame.tx_type == FAN_TYPE_MAIN_UNIT ? "Main" : "?", frame.tx_id, joinOpen.networkId);
 
-          this->rfComplete();
+          // Would be stored as a pairing that startup rejects; keep waiting for a proper offer
+          if ((joinOpen.networkId == 0x00000000) || (frame.tx_type == 0) || (frame.tx_id == 0)) {
+            ESP_LOGW(TAG, "Discovery: Ignoring invalid network offer");
+            break;
+          }
 
-          (void) memset(this->_txFrame, 0, FAN_FRAMESIZE);  // Clear frame data
+          this->rfComplete();
 
-          // Found a main unit, so send a join request
-          pTxFrame->rx_type = FAN_TYPE_MAIN_UNIT;  // Set type to main unit
-          pTxFrame->rx_id = pResponse->tx_id;      // Set ID to the ID of the main unit
-          pTxFrame->tx_type = this->config_.fan_my_device_type;
-          pTxFrame->tx_id = this->config_.fan_my_device_id;
-          pTxFrame->ttl = FAN_TTL;
-          pTxFrame->command = FAN_NETWORK_JOIN_REQUEST;  // Request to connect to network
-          pTxFrame->parameter_count = sizeof(RfPayloadNetworkJoinOpen);
-          // Request to connect to the received network ID
-          pTxFrame->payload.networkJoinRequest.networkId = pResponse->payload.networkJoinOpen.networkId;
+          // Found a main unit (set ID to the ID of the main unit), so request to connect to the received network ID
+          rfFrameEncode(this->_txFrame,
+                        {FAN_TYPE_MAIN_UNIT, frame.tx_id, this->config_.fan_my_device_type,
+                         this->config_.fan_my_device_id},
+                        RfPayloadNetworkJoinRequest{joinOpen.networkId});
 
           // Store for later
-          this->config_.fan_networkId = pResponse->payload.networkJoinOpen.networkId;
-          this->config_.fan_main_unit_type = pResponse->tx_type;
-          this->config_.fan_main_unit_id = pResponse->tx_id;
+          this->config_.fan_networkId = joinOpen.networkId;
+          this->config_.fan_main_unit_type = frame.tx_type;
+          this->config_.fan_main_unit_id = frame.tx_id;
 
           // Update address
-          rfConfig = this->rf_->getConfig();
-          rfConfig.rx_address = pResponse->payload.networkJoinOpen.networkId;
-          this->rf_->updateConfig(&rfConfig, NULL);
-          this->rf_->writeTxAddress(pResponse->payload.networkJoinOpen.networkId, NULL);
+          this->rfSetAddress(joinOpen.networkId);
 
           // Send response frame
           this->startTransmit(this->_txFrame, FAN_TX_RETRIES, [this]() {
@@ -318,36 +369,31 @@ void ZehnderRF::rfHandleReceived(const uint8_t *const pData, const uint8_t dataL
           break;
 
         default:
-          ESP_LOGD(TAG, "Discovery: Received unknown frame type 0x%02X from ID 0x%02X", pResponse->command,
-                   pResponse->tx_id);
+          ESP_LOGD(TAG, "Discovery: Received unknown frame type 0x%02X from ID 0x%02X", frame.command,
+                   frame.tx_id);
           break;
       }
       break;
 
     case StateDiscoveryWaitForJoinResponse:
       ESP_LOGD(TAG, "Discovery state: waiting for join response");
-      switch (pResponse->command) {
+      switch (frame.command) {
         case FAN_FRAME_0B:
-          if ((pResponse->rx_type == this->config_.fan_my_device_type) &&
-              (pResponse->rx_id == this->config_.fan_my_device_id) &&
-              (pResponse->tx_type == this->config_.fan_main_unit_type) &&
-              (pResponse->tx_id == this->config_.fan_main_unit_id)) {
-            ESP_LOGD(TAG, "Discovery: Link successful to unit with ID 0x%02X on network 0x%08X", pResponse->tx_id,
+          if ((frame.rx_type == this->config_.fan_my_device_type) &&
+              (frame.rx_id == this->config_.fan_my_device_id) &&
+              (frame.tx_type == this->config_.fan_main_unit_type) &&
+              (frame.tx_id == this->config_.fan_main_unit_id)) {
+            ESP_LOGD(TAG, "Discovery: Link successful to unit with ID 0x%02X on network 0x%08X", frame.tx_id,
                      this->config_.fan_networkId);
 
             this->rfComplete();
 
-            (void) memset(this->_txFrame, 0, FAN_FRAMESIZE);  // Clear frame data
-
-            pTxFrame->rx_type = FAN_TYPE_MAIN_UNIT;  // Set type to main unit
-            pTxFrame->rx_id = pResponse->tx_id;      // Set ID to the ID of the main unit
-            // pTxFrame->rx_id = 0x00;  // Broadcast - this should fix the CO2 sensor overriding the call?
-            // Per https://github.com/TimelessNL/ESPHome-Zehnder-RF/pull/1 we shouldn't broadcast on link success
-            pTxFrame->tx_type = this->config_.fan_my_device_type;
-            pTxFrame->tx_id = this->config_.fan_my_device_id;
-            pTxFrame->ttl = FAN_TTL;
-            pTxFrame->command = FAN_FRAME_0B;  // 0x0B acknowledge link successful
-            pTxFrame->parameter_count = 0x00;  // No parameters
+            // Addressed to the main unit; broadcasting (rx_id 0x00) was tried against the CO2 sensor overriding the call,
+            // but per https://github.com/TimelessNL/ESPHome-Zehnder-RF/pull/1 we shouldn't broadcast on link success
+            rfFrameEncode(this->_txFrame,
+                          {FAN_TYPE_MAIN_UNIT, frame.tx_id, this->config_.fan_my_device_type,
+                           this->config_.fan_my_device_id},
+                          RfPayloadLinkSuccess{});
 
             // Send response frame
             this->startTransmit(this->_txFrame, FAN_TX_RETRIES, [this]() {
@@ -357,26 +403,26 @@ void ZehnderRF::rfHandleReceived(const uint8_t *const pData, const uint8_t dataL
 
             this->state_ = StateDiscoveryJoinComplete;
           } else {
-            ESP_LOGE(TAG, "Discovery: Received unknown link success from ID 0x%02X on network 0x%08X", pResponse->tx_id,
+            ESP_LOGE(TAG, "Discovery: Received unknown link success from ID 0x%02X on network 0x%08X", frame.tx_id,
                      this->config_.fan_networkId);
           }
           break;
 
         default:
-          ESP_LOGE(TAG, "Discovery: Received unknown frame type 0x%02X from ID 0x%02X", pResponse->command,
-                   pResponse->tx_id);
+          ESP_LOGE(TAG, "Discovery: Received unknown frame type 0x%02X from ID 0x%02X", frame.command,
+                   frame.tx_id);
           break;
       }
       break;
 
     case StateDiscoveryJoinComplete:
       ESP_LOGD(TAG, "Discovery state: join complete");
-      switch (pResponse->command) {
+      switch (frame.command) {
         case FAN_TYPE_QUERY_NETWORK:
-          if ((pResponse->rx_type == this->config_.fan_main_unit_type) &&
-              (pResponse->rx_id == this->config_.fan_main_unit_id) &&
-              (pResponse->tx_type == this->config_.fan_main_unit_type) &&
-              (pResponse->tx_id == this->config_.fan_main_unit_id)) {
+          if ((frame.rx_type == this->config_.fan_main_unit_type) &&
+              (frame.rx_id == this->config_.fan_main_unit_id) &&
+              (frame.tx_type == this->config_.fan_main_unit_type) &&
+              (frame.tx_id == this->config_.fan_main_unit_id)) {
             ESP_LOGD(TAG, "Discovery: received network join success");
 
             this->rfComplete();
@@ -384,83 +430,72 @@ void ZehnderRF::rfHandleReceived(const uint8_t *const pData, const uint8_t dataL
             ESP_LOGI(TAG, "Pairing completed successfully with main unit type 0x%02X ID 0x%02X", this->config_.fan_main_unit_type, this->config_.fan_main_unit_id);
             ESP_LOGD(TAG, "Saving pairing configuration");
             this->pref_.save(&this->config_);
+            this->buildFrameTemplates();
 
             this->state_ = StateIdle;
           } else {
-            ESP_LOGW(TAG, "Unexpected frame join response from Type 0x%02X ID 0x%02X", pResponse->tx_type,
-                     pResponse->tx_id);
+            ESP_LOGW(TAG, "Unexpected frame join response from Type 0x%02X ID 0x%02X", frame.tx_type,
+                     frame.tx_id);
           }
           break;
 
         default:
           ESP_LOGE(TAG, "Discovery: Received unknown frame type 0x%02X from ID 0x%02X on network 0x%08X",
-                   pResponse->command, pResponse->tx_id, this->config_.fan_networkId);
+                   frame.command, frame.tx_id, this->config_.fan_networkId);
           break;
       }
       break;
 
     case StateWaitQueryResponse:
-      if ((pResponse->rx_type == this->config_.fan_my_device_type) &&  // If type
-          (pResponse->rx_id == this->config_.fan_my_device_id)) {      // and id match, it is for us
-        switch (pResponse->command) {
+      if ((frame.rx_type == this->config_.fan_my_device_type) &&  // If type
+          (frame.rx_id == this->config_.fan_my_device_id)) {      // and id match, it is for us
+        switch (frame.command) {
           case FAN_TYPE_FAN_SETTINGS:
-            ESP_LOGD(TAG, "Received fan settings; speed: 0x%02X voltage: %i timer: %i",
-                     pResponse->payload.fanSettings.speed, pResponse->payload.fanSettings.voltage,
-                     pResponse->payload.fanSettings.timer);
+            settings = frame.payload<RfPayloadFanSettings>();
+            ESP_LOGD(TAG, "Received fan settings; speed: 0x%02X voltage: %i timer: %i", settings.speed,
+                     settings.voltage, settings.timer);
 
             this->rfComplete();
+            this->latencyReply();
+            this->latencyFinish();
 
-            this->state = pResponse->payload.fanSettings.speed > 0;
-            this->speed = pResponse->payload.fanSettings.speed;
-            this->timer = pResponse->payload.fanSettings.timer;
-            this->voltage = clamp_voltage(pResponse->payload.fanSettings.voltage);
-            this->publish_state();
+            this->schedulePoll(this->applyFanSettings(settings));
 
             this->state_ = StateIdle;
             break;
 
           default:
-            ESP_LOGD(TAG, "Received unexpected frame; type 0x%02X from ID 0x%02X", pResponse->command,
-                     pResponse->tx_id);
+            ESP_LOGD(TAG, "Received unexpected frame; type 0x%02X from ID 0x%02X", frame.command,
+                     frame.tx_id);
             break;
         }
       } else {
-        ESP_LOGD(TAG, "Received frame from unknown device; type 0x%02X from ID 0x%02X type 0x%02X", pResponse->command,
-                 pResponse->tx_id, pResponse->tx_type);
+        ESP_LOGD(TAG, "Received frame from unknown device; type 0x%02X from ID 0x%02X type 0x%02X", frame.command,
+                 frame.tx_id, frame.tx_type);
       }
       break;
 
     case StateWaitSetSpeedResponse:
-      if ((pResponse->rx_type == this->config_.fan_my_device_type) &&  // If type
-          (pResponse->rx_id == this->config_.fan_my_device_id)) {      // and id match, it is for us
-        switch (pResponse->command) {
+      if ((frame.rx_type == this->config_.fan_my_device_type) &&  // If type
+          (frame.rx_id == this->config_.fan_my_device_id)) {      // and id match, it is for us
+        switch (frame.command) {
           case FAN_TYPE_FAN_SETTINGS:
-            ESP_LOGD(TAG, "Received fan settings; speed: 0x%02X voltage: %i timer: %i",
-                     pResponse->payload.fanSettings.speed, pResponse->payload.fanSettings.voltage,
-                     pResponse->payload.fanSettings.timer);
-            // No idea why we need to commit twice, but got it from TimelessNL b4ae8c4
+            settings = frame.payload<RfPayloadFanSettings>();
+            ESP_LOGD(TAG, "Received fan settings; speed: 0x%02X voltage: %i timer: %i", settings.speed,
+                     settings.voltage, settings.timer);
             this->rfComplete();
+            this->latencyReply();
 
-            this->rfComplete();
+            this->applyFanSettings(settings);
+
+            // Follow the fan closely while it settles on the new speed
+            this->fastPolls_ = FAN_POLL_FAST_COUNT;
+            this->schedulePoll(true);
 
-            this->state = pResponse->payload.fanSettings.speed > 0;
-            this->speed = pResponse->payload.fanSettings.speed;
-            this->timer = pResponse->payload.fanSettings.timer;
-            this->voltage = clamp_voltage(pResponse->payload.fanSettings.voltage);
-            this->publish_state();
-
-            (void) memset(this->_txFrame, 0, FAN_FRAMESIZE);  // Clear frame data
-
-            pTxFrame->rx_type = this->config_.fan_main_unit_type;  // Set type to main unit
-            pTxFrame->rx_id = this->config_.fan_main_unit_id;      // Set ID to the ID of the main unit
-            pTxFrame->tx_type = this->config_.fan_my_device_type;
-            pTxFrame->tx_id = this->config_.fan_my_device_id;
-            pTxFrame->ttl = FAN_TTL;
-            pTxFrame->command = FAN_FRAME_SETSPEED_REPLY;  // 0x0B acknowledge link successful
-            pTxFrame->parameter_count = 0x03;              // 3 parameters
-            pTxFrame->payload.parameters[0] = 0x54;
-            pTxFrame->payload.parameters[1] = 0x03;
-            pTxFrame->payload.parameters[2] = 0x20;
+            rfFrameEncode(this->_txFrame,
+                          {this->config_.fan_main_unit_type, this->config_.fan_main_unit_id,
+                           this->config_.fan_my_device_type, this->config_.fan_my_device_id},
+                          RfPayloadSetSpeedReply{});
 
             // Send response frame
             this->startTransmit(this->_txFrame, -1, NULL);
@@ -476,21 +511,205 @@ void ZehnderRF::rfHandleReceived(const uint8_t *const pData, const uint8_t dataL
             break;
 
           default:
-            ESP_LOGD(TAG, "Received unexpected frame; type 0x%02X from ID 0x%02X", pResponse->command,
-                     pResponse->tx_id);
+            ESP_LOGD(TAG, "Received unexpected frame; type 0x%02X from ID 0x%02X", frame.command,
+                     frame.tx_id);
             break;
         }
       } else {
-        ESP_LOGD(TAG, "Received frame from unknown device; type 0x%02X from ID 0x%02X type 0x%02X", pResponse->command,
-                 pResponse->tx_id, pResponse->tx_type);
+        ESP_LOGD(TAG, "Received frame from unknown device; type 0x%02X from ID 0x%02X type 0x%02X", frame.command,
+                 frame.tx_id, frame.tx_type);
       }
       break;
 
     default:
       ESP_LOGD(TAG, "Received frame from unknown device in unknown state; type 0x%02X from ID 0x%02X type 0x%02X",
-               pResponse->command, pResponse->tx_id, pResponse->tx_type);
+               frame.command, frame.tx_id, frame.tx_type);
+      break;
+  }
+}
+
+void ZehnderRF::latencyStart(const Command &command) {
+  this->latencyTrace_.active = true;
+  this->latencyTrace_.type = command.type;
+  this->latencyTrace_.seq = this->txSeq_;
+  this->latencyTrace_.queuedAt = command.firstQueuedAt;
+  this->latencyTrace_.txStartAt = 0;
+  this->latencyTrace_.txDoneAt = 0;
+  this->latencyTrace_.replyAt = 0;
+}
+
+void ZehnderRF::latencyReply(void) {
+  if (!this->latencyTrace_.active) {
+    return;
+  }
+
+  // The engine's timestamps, unless it has moved on to another transmission already
+  if (this->rfTimingSeq_ == this->latencyTrace_.seq) {
+    this->latencyTrace_.txStartAt = this->rfTxStartAt_;
+    this->latencyTrace_.txDoneAt = this->rfTxDoneAt_;
+  }
+  this->latencyTrace_.replyAt = this->rxTimestamp_;
+}
+
+void ZehnderRF::latencyFinish(void) {
+  LatencyTrace *const pTrace = &this->latencyTrace_;
+  LatencyHistogram *const pHistograms = this->latency_[pTrace->type];
+  const uint32_t now = millis();
+  uint32_t stages[LatencyNrOf] = {};
+
+  if (!pTrace->active) {
+    return;
+  }
+  pTrace->active = false;
+
+  stages[LatencyTotal] = now - pTrace->queuedAt;
+  pHistograms[LatencyTotal].add(stages[LatencyTotal]);
+
+  // A reply to an earlier attempt can come in while a retry is on air; the stages of that one do not add up
+  if ((pTrace->txStartAt != 0) && (pTrace->txDoneAt != 0) && ((int32_t) (pTrace->txStartAt - pTrace->queuedAt) >= 0) &&
+      ((int32_t) (pTrace->txDoneAt - pTrace->txStartAt) >= 0) &&
+      ((int32_t) (pTrace->replyAt - pTrace->txDoneAt) >= 0)) {
+    stages[LatencyWait] = pTrace->txStartAt - pTrace->queuedAt;
+    stages[LatencyTransmit] = pTrace->txDoneAt - pTrace->txStartAt;
+    stages[LatencyReply] = pTrace->replyAt - pTrace->txDoneAt;
+    pHistograms[LatencyWait].add(stages[LatencyWait]);
+    pHistograms[LatencyTransmit].add(stages[LatencyTransmit]);
+    pHistograms[LatencyReply].add(stages[LatencyReply]);
+  }
+  if ((pTrace->type == CommandSetSpeed) && ((int32_t) (now - pTrace->replyAt) >= 0)) {
+    stages[LatencyConfirm] = now - pTrace->replyAt;
+    pHistograms[LatencyConfirm].add(stages[LatencyConfirm]);
+  }
+
+  ESP_LOGD(TAG, "%s done in %u ms; wait %u, transmit %u, reply %u, confirm %u ms",
+           pTrace->type == CommandSetSpeed ? "Speed command" : "Poll", stages[LatencyTotal], stages[LatencyWait],
+           stages[LatencyTransmit], stages[LatencyReply], stages[LatencyConfirm]);
+}
+
+uint32_t ZehnderRF::getCommandLatency(const uint8_t percentile) {
+  return this->latency_[CommandSetSpeed][LatencyTotal].percentile(percentile);
+}
+
+uint32_t ZehnderRF::getQueryLatency(const uint8_t percentile) {
+  return this->latency_[CommandQuery][LatencyTotal].percentile(percentile);
+}
+
+bool ZehnderRF::applyFanSettings(const RfPayloadFanSettings &settings) {
+  const bool state = settings.speed > 0;
+  const int speed = clamp_speed(settings.speed, this->speed_count_);
+  const bool timer = settings.timer;
+  const int voltage = clamp_voltage(settings.voltage);
+  const bool changed =
+      (state != this->state) || (speed != this->speed) || (timer != this->timer) || (voltage != this->voltage);
+
+  this->state = state;
+  this->speed = speed;
+  this->timer = timer;
+  this->voltage = voltage;
+  this->publishSettings(false);
+
+  return changed;
+}
+
+void ZehnderRF::publishSettings(const bool force) {
+  const bool changed = !this->published_.valid || (this->state != this->published_.state) ||
+                       (this->speed != this->published_.speed) || (this->timer != this->published_.timer) ||
+                       (this->voltage != this->published_.voltage);
+
+  if (!force && !changed) {
+    ++this->publishesSuppressed_;
+    this->publishPending_ = false;
+    return;
+  }
+  if (!force && this->published_.valid && ((millis() - this->lastPublish_) < this->publishMinInterval_)) {
+    // Sent from loop() once the interval has passed, with whatever the state is by then
+    ++this->publishesSuppressed_;
+    this->publishPending_ = true;
+    return;
+  }
+
+  this->publish_state();
+
+  this->published_.valid = true;
+  this->published_.state = this->state;
+  this->published_.speed = this->speed;
+  this->published_.timer = this->timer;
+  this->published_.voltage = this->voltage;
+  this->lastPublish_ = millis();
+  this->publishPending_ = false;
+  ++this->publishesEmitted_;
+}
+
+void ZehnderRF::schedulePoll(const bool changed) {
+  // The base interval always lies within the bounds, whatever was configured
+  const uint32_t floor = std::min(this->intervalMin_, this->interval_);
+  const uint32_t ceiling = std::max(this->intervalMax_, this->interval_);
+  uint64_t delay = this->interval_;
+  uint32_t jitter;
+
+  if (changed) {
+    this->unchangedPolls_ = 0;
+  } else if (this->unchangedPolls_ < 0xFF) {
+    ++this->unchangedPolls_;
+  }
+
+  if ((this->fastPolls_ > 0) || this->timer) {
+    // Right after a command, or while a timer counts down
+    delay = floor;
+    if (this->fastPolls_ > 0) {
+      --this->fastPolls_;
+    }
+  } else if (this->unchangedPolls_ > FAN_POLL_BACKOFF_AFTER) {
+    // Nothing happening, double the interval with every further poll that brings no news
+    delay <<= std::min(this->unchangedPolls_ - FAN_POLL_BACKOFF_AFTER, 16);
+  }
+
+  // Bridges that started together must not keep polling at the same moment
+  jitter = (uint32_t) (delay * FAN_POLL_JITTER / 100);
+  if (jitter > 0) {
+    delay = delay - jitter + (random_uint32() % (2 * jitter + 1));
+  }
+
+  this->pollDelay_ = (uint32_t) std::max<uint64_t>(floor, std::min<uint64_t>(delay, ceiling));
+  ESP_LOGV(TAG, "Next poll in %u ms", this->pollDelay_);
+}
+
+bool ZehnderRF::trackFanSettings(const RfFrame &frame) {
+  RfPayloadFanSettings settings;
+
+  if (!this->passiveTracking_ || (frame.command != FAN_TYPE_FAN_SETTINGS) ||
+      (frame.tx_type != this->config_.fan_main_unit_type) || (frame.tx_id != this->config_.fan_main_unit_id)) {
+    return false;
+  }
+
+  switch (this->state_) {
+    case StateWaitQueryResponse:
+      if ((frame.rx_type == this->config_.fan_my_device_type) && (frame.rx_id == this->config_.fan_my_device_id)) {
+        return false;  // The reply to our poll
+      }
+      break;
+
+    case StateIdle:
+    case StateWaitSetSpeedConfirm:
       break;
+
+    default:
+      // Not paired yet, or the settings may predate the speed command we are waiting on
+      return false;
   }
+
+  settings = frame.payload<RfPayloadFanSettings>();
+  ESP_LOGD(TAG, "Overheard fan settings for type 0x%02X ID 0x%02X; speed: 0x%02X voltage: %i timer: %i",
+           frame.rx_type, frame.rx_id, settings.speed, settings.voltage, settings.timer);
+
+  // As good as a poll reply
+  if (this->applyFanSettings(settings)) {
+    this->schedulePoll(true);
+  }
+  this->update_connection_status(true);
+  this->lastFanQuery_ = millis();
+
+  return true;
 }
 
 uint8_t ZehnderRF::createDeviceID(void) {
@@ -503,28 +722,33 @@ uint8_t ZehnderRF::createDeviceID(void) {
   return minmax(random, 1, 0xFE);
 }
 
-void ZehnderRF::queryDevice(void) {
-  RfFrame *const pFrame = (RfFrame *) this->_txFrame;  // frame helper
+void ZehnderRF::buildFrameTemplates(void) {
+  const RfAddress mainUnit = {this->config_.fan_main_unit_type, this->config_.fan_main_unit_id,
+                              this->config_.fan_my_device_type, this->config_.fan_my_device_id};
+
+  rfFrameEncode(this->_queryFrame, mainUnit, RfPayloadQueryDevice{});
+
+  // Speed commands are broadcast (rx_id 0x00), posing as the remote that would send them. Auto is both the timer and
+  // speed 0, which mimics the Timer RF 'OFF' command
+  rfFrameEncode(this->_setSpeedFrames[FAN_SPEED_AUTO],
+                {this->config_.fan_main_unit_type, 0x00, FAN_TYPE_TIMER_REMOTE_CONTROL, this->config_.fan_my_device_id},
+                RfPayloadFanSetTimer{FAN_SPEED_AUTO, 0});
+  for (uint8_t speed = FAN_SPEED_LOW; speed <= FAN_SPEED_MAX; ++speed) {
+    rfFrameEncode(this->_setSpeedFrames[speed],
+                  {this->config_.fan_main_unit_type, 0x00, FAN_TYPE_CO2_SENSOR, this->config_.fan_my_device_id},
+                  RfPayloadFanSetSpeed{speed});
+  }
+}
 
+void ZehnderRF::queryDevice(void) {
   ESP_LOGD(TAG, "Query device");
 
   this->lastFanQuery_ = millis();  // Update time
 
-  // Clear frame data
-  (void) memset(this->_txFrame, 0, FAN_FRAMESIZE);
-
-  // Build frame
-  pFrame->rx_type = this->config_.fan_main_unit_type;
-  pFrame->rx_id = this->config_.fan_main_unit_id;
-  pFrame->tx_type = this->config_.fan_my_device_type;
-  pFrame->tx_id = this->config_.fan_my_device_id;
-  pFrame->ttl = FAN_TTL;
-  pFrame->command = FAN_TYPE_QUERY_DEVICE;
-  pFrame->parameter_count = 0x00;  // No parameters
-
-  this->startTransmit(this->_txFrame, FAN_TX_RETRIES, [this]() {
+  this->startTransmit(this->_queryFrame, FAN_TX_RETRIES, [this]() {
     ESP_LOGW(TAG, "Device query timeout, returning to idle state");
     this->update_connection_status(false);
+    this->schedulePoll(true);  // No backing off from a fan that does not answer
     this->state_ = StateIdle;
   });
 
@@ -532,92 +756,150 @@ void ZehnderRF::queryDevice(void) {
 }
 
 void ZehnderRF::setSpeed(const uint8_t paramSpeed, const uint8_t paramTimer) {
-  RfFrame *const pFrame = (RfFrame *) this->_txFrame;  // frame helper
   uint8_t speed = paramSpeed;
-  uint8_t timer = paramTimer;
 
   if (speed > this->speed_count_) {
     ESP_LOGW(TAG, "Requested speed %u exceeds maximum %u, clamping to maximum", speed, this->speed_count_);
     speed = this->speed_count_;
   }
 
-  ESP_LOGI(TAG, "Set speed: 0x%02X; Timer %u minutes", speed, timer);
+  ESP_LOGI(TAG, "Set speed: 0x%02X; Timer %u minutes", speed, paramTimer);
 
-  if (this->state_ == StateIdle) {
-    (void) memset(this->_txFrame, 0, FAN_FRAMESIZE);  // Clear frame data
+  this->queueCommand(CommandSetSpeed, speed, paramTimer, this->commandMaxAge_);
+  this->processCommands();
+}
 
-    // Build frame
-    pFrame->rx_type = this->config_.fan_main_unit_type;
-    pFrame->rx_id = 0x00;  // Broadcast
-    // pFrame->tx_type = this->config_.fan_my_device_type;
-    pFrame->tx_id = this->config_.fan_my_device_id;
-    pFrame->ttl = FAN_TTL;
+void ZehnderRF::sendSpeed(const uint8_t speed, const uint8_t timer) {
+  const uint8_t *pFrame;
 
-    if (timer == 0 && speed == 0) {
-      // We want to switch to auto by setting both the timer and speed to 0
-      // This mimics the Timer RF 'OFF' command.
-      pFrame->tx_type = FAN_TYPE_TIMER_REMOTE_CONTROL;
-      pFrame->command = FAN_FRAME_SETTIMER;
-      pFrame->parameter_count = sizeof(RfPayloadFanSetTimer);
-      pFrame->payload.setTimer.speed = speed;
-      pFrame->payload.setTimer.timer = timer;
+  if (timer == 0) {
+    // Presets and auto are precomputed
+    pFrame = this->_setSpeedFrames[speed];
+  } else {
+    // Build frame, broadcast (rx_id 0x00) as the timer remote we pose as would
+    rfFrameEncode(this->_txFrame,
+                  {this->config_.fan_main_unit_type, 0x00, FAN_TYPE_TIMER_REMOTE_CONTROL,
+                   this->config_.fan_my_device_id},
+                  RfPayloadFanSetTimer{speed, timer});
+    pFrame = this->_txFrame;
+  }
+
+  this->startTransmit(pFrame, FAN_TX_RETRIES, [this]() {
+    ESP_LOGW(TAG, "Set speed timeout, returning to idle state");
+    this->update_connection_status(false);
+    this->state_ = StateIdle;
+  });
+
+  this->lastFanQuery_ = millis();  // The reply carries the fan settings, no need to poll
+  this->state_ = StateWaitSetSpeedResponse;
+}
+
+void ZehnderRF::queueCommand(const CommandType type, const uint8_t speed, const uint8_t timer, const uint32_t maxAge) {
+  Command *pCommand = NULL;
+
+  // Last write wins
+  for (uint8_t i = 0; i < this->commandCount_; ++i) {
+    if (this->commandQueue_[i].type == type) {
+      pCommand = &this->commandQueue_[i];
+      break;
     }
-    else if (timer == 0) {
-      pFrame->tx_type = FAN_TYPE_CO2_SENSOR;
-      pFrame->command = FAN_FRAME_SETSPEED;
-      pFrame->parameter_count = sizeof(RfPayloadFanSetSpeed);
-      pFrame->payload.setSpeed.speed = speed;
+  }
+  if (pCommand == NULL) {
+    pCommand = &this->commandQueue_[this->commandCount_++];
+    pCommand->firstQueuedAt = millis();
+  } else if (type == CommandSetSpeed) {
+    ESP_LOGD(TAG, "Replacing pending speed 0x%02X timer %u", pCommand->speed, pCommand->timer);
+  }
+
+  // The age runs from the latest request, so the command just made is not stale at once; latency counts from the
+  // first one
+  pCommand->type = type;
+  pCommand->speed = speed;
+  pCommand->timer = timer;
+  pCommand->queuedAt = millis();
+  pCommand->maxAge = maxAge;
+}
+
+bool ZehnderRF::takeCommand(Command *const pCommand) {
+  const uint32_t now = millis();
+  uint8_t best = this->commandCount_;
+  uint8_t i = 0;
+
+  while (i < this->commandCount_) {
+    if ((now - this->commandQueue_[i].queuedAt) > this->commandQueue_[i].maxAge) {
+      ESP_LOGW(TAG, "Dropping command %u, not sent within %u ms", this->commandQueue_[i].type,
+               this->commandQueue_[i].maxAge);
+      ++this->commandsDropped_;
+      this->commandQueue_[i] = this->commandQueue_[--this->commandCount_];
+      best = this->commandCount_;  // Order changed, start over
+      i = 0;
     } else {
-      pFrame->tx_type = FAN_TYPE_TIMER_REMOTE_CONTROL;
-      pFrame->command = FAN_FRAME_SETTIMER;
-      pFrame->parameter_count = sizeof(RfPayloadFanSetTimer);
-      pFrame->payload.setTimer.speed = speed;
-      pFrame->payload.setTimer.timer = timer;
+      if ((best == this->commandCount_) || (this->commandQueue_[i].type < this->commandQueue_[best].type)) {
+        best = i;
+      }
+      ++i;
     }
+  }
 
-    this->startTransmit(this->_txFrame, FAN_TX_RETRIES, [this]() {
-      ESP_LOGW(TAG, "Set speed timeout, returning to idle state");
-      this->update_connection_status(false);
-      this->state_ = StateIdle;
-    });
+  if (best == this->commandCount_) {
+    return false;
+  }
 
-    newSetting = false;
-    this->state_ = StateWaitSetSpeedResponse;
-  } else {
-    ESP_LOGD(TAG, "Invalid state for speed setting, will retry later");
-    newSpeed = speed;
-    newTimer = timer;
-    newSetting = true;
+  *pCommand = this->commandQueue_[best];
+  this->commandQueue_[best] = this->commandQueue_[--this->commandCount_];
+
+  return true;
+}
+
+bool ZehnderRF::userCommandPending(void) {
+  for (uint8_t i = 0; i < this->commandCount_; ++i) {
+    if (this->commandQueue_[i].type == CommandSetSpeed) {
+      return true;
+    }
   }
+
+  return false;
 }
 
-void ZehnderRF::discoveryStart(const uint8_t deviceId) {
-  RfFrame *const pFrame = (RfFrame *) this->_txFrame;  // frame helper
-  nrf905::Config rfConfig;
+void ZehnderRF::processCommands(void) {
+  Command command;
+
+  if ((this->state_ != StateIdle) || this->rfBusy_) {
+    return;  // Busy, stays queued
+  }
 
+  if (this->takeCommand(&command)) {
+    switch (command.type) {
+      case CommandSetSpeed:
+        this->sendSpeed(command.speed, command.timer);
+        break;
+
+      case CommandQuery:
+        this->queryDevice();
+        break;
+
+      default:
+        break;
+    }
+
+    if (this->rfBusy_) {
+      this->latencyStart(command);
+    }
+  }
+}
+
+void ZehnderRF::discoveryStart(const uint8_t deviceId) {
   ESP_LOGD(TAG, "Starting discovery with device ID %u", deviceId);
 
   this->config_.fan_my_device_type = FAN_TYPE_REMOTE_CONTROL;
   this->config_.fan_my_device_id = deviceId;
 
-  // Build frame
-  (void) memset(this->_txFrame, 0, FAN_FRAMESIZE);  // Clear frame data
-
-  // Set payload, available for linking
-  pFrame->rx_type = 0x04;
-  pFrame->rx_id = 0x00;
-  pFrame->tx_type = this->config_.fan_my_device_type;
-  pFrame->tx_id = this->config_.fan_my_device_id;
-  pFrame->ttl = FAN_TTL;
-  pFrame->command = FAN_NETWORK_JOIN_ACK;
-  pFrame->parameter_count = sizeof(RfPayloadNetworkJoinAck);
-  pFrame->payload.networkJoinAck.networkId = NETWORK_LINK_ID;
+  // Build frame, available for linking
+  rfFrameEncode(this->_txFrame, {0x04, 0x00, this->config_.fan_my_device_type, this->config_.fan_my_device_id},
+                RfPayloadNetworkJoinAck{NETWORK_LINK_ID});
 
   // Set RX and TX address
-  rfConfig = this->rf_->getConfig();
-  rfConfig.rx_address = NETWORK_LINK_ID;
-  this->rf_->updateConfig(&rfConfig, NULL);
-  this->rf_->writeTxAddress(NETWORK_LINK_ID, NULL);
+  this->rfSetAddress(NETWORK_LINK_ID);
 
   this->startTransmit(this->_txFrame, FAN_TX_RETRIES, [this]() {
     ESP_LOGW(TAG, "Discovery start timeout, retrying");
@@ -629,54 +911,257 @@ void ZehnderRF::discoveryStart(const uint8_t deviceId) {
 }
 
 Result ZehnderRF::startTransmit(const uint8_t *const pData, const int8_t rxRetries,
-                                const std::function<void(void)> callback) {
+                                const TimeoutCallback callback) {
   Result result = ResultOk;
-  unsigned long startTime;
-  bool busy = true;
+  RfCommand command;
 
-  if (this->rfState_ != RfStateIdle) {
+  if (this->rfBusy_) {
     ESP_LOGW(TAG, "RF transmission still ongoing, cannot start new transmission");
     result = ResultBusy;
   } else {
     this->onReceiveTimeout_ = callback;
-    this->retries_ = rxRetries;
-
-    // Write data to RF
-    // if (pData != NULL) {  // If frame given, load it in the nRF. Else use previous TX payload
-    this->rf_->writeTxPayload(pData, FAN_FRAMESIZE);  // Use framesize
-    // }
-
-    this->rfState_ = RfStateWaitAirwayFree;
-    this->airwayFreeWaitTime_ = millis();
+    this->rfBusy_ = true;
+    this->radioIdle_ = false;
+
+    command.type = RfCommandTransmit;
+    command.seq = ++this->txSeq_;
+    command.retries = rxRetries;
+    memcpy(command.frame, pData, FAN_FRAMESIZE);
+    this->rfPost(command);
   }
 
   return result;
 }
 
 void ZehnderRF::rfComplete(void) {
-  this->retries_ = -1;  // Disable this->retries_
-  this->rfState_ = RfStateIdle;
-  
+  RfCommand command;
+
+  if (this->rfBusy_) {
+    command.type = RfCommandComplete;
+    command.seq = this->txSeq_;
+    command.time = this->rxTimestamp_;
+    this->rfPost(command);
+
+    this->onReceiveTimeout_ = NULL;
+    this->rfBusy_ = false;
+  }
+
   // Update connection status on successful communication
   this->update_connection_status(true);
 }
 
+void ZehnderRF::rfCancel(void) {
+  RfCommand command;
+
+  command.type = RfCommandCancel;
+  command.seq = this->txSeq_;
+  this->rfPost(command);
+
+  this->onReceiveTimeout_ = NULL;
+  this->rfBusy_ = false;
+  this->latencyTrace_.active = false;  // Given up on, not a latency
+}
+
+void ZehnderRF::rfSetAddress(const uint32_t address) {
+  RfCommand command;
+
+  command.type = RfCommandSetAddress;
+  command.address = address;
+  this->rfPost(command);
+}
+
+void ZehnderRF::rfSetIdleMode(const nrf905::Mode mode) {
+  RfCommand command;
+
+  command.type = RfCommandSetMode;
+  command.mode = mode;
+  this->rfPost(command);
+  this->radioIdle_ = true;
+}
+
+void ZehnderRF::rfPost(const RfCommand &command) {
+  if (!this->rfCommands_.push(command)) {
+    // Cannot happen while the engine keeps up; the protocol recovers through its own timeouts
+    this->rfCommandOverflows_.fetch_add(1, std::memory_order_relaxed);
+    ESP_LOGE(TAG, "RF command queue full, command 0x%02X dropped", command.type);
+  }
+#ifdef USE_ESP32
+  if (this->rfTaskHandle_ != NULL) {
+    xTaskNotifyGive(this->rfTaskHandle_);
+  }
+#endif
+}
+
+// Protocol side: results of the transmissions; stale ones, of a transmission given up on, are ignored
+void ZehnderRF::rfHandleEvents(void) {
+  RfEvent *pEvent;
+  RfEvent event;
+  TimeoutCallback callback;
+
+  while ((pEvent = this->rfEvents_.peek()) != nullptr) {
+    event = *pEvent;
+    this->rfEvents_.pop();
+
+    if (event.type == RfEventModeDropped) {
+      this->radioIdle_ = false;
+      continue;
+    }
+
+    if (!this->rfBusy_ || (event.seq != this->txSeq_)) {
+      continue;
+    }
+
+    this->rfBusy_ = false;
+    if (event.type == RfEventTimeout) {
+      this->latencyTrace_.active = false;
+      callback = this->onReceiveTimeout_;
+      this->onReceiveTimeout_ = NULL;
+      if (callback != NULL) {
+        callback();
+      }
+    }
+  }
+}
+
+#ifdef USE_ESP32
+void ZehnderRF::rfTaskEntry(void *arg) {
+  ZehnderRF *const self = (ZehnderRF *) arg;
+
+  while (true) {
+    self->rf_->service();
+    self->rfTaskStep();
+
+    // Woken by new commands, else look at the radio every tick
+    ulTaskNotifyTake(pdTRUE, 1);
+  }
+}
+#endif
+
+// Engine side: take the requests of the protocol, then run the transmit state machine
+void ZehnderRF::rfTaskStep(void) {
+  RfCommand *pCommand;
+
+  while ((pCommand = this->rfCommands_.peek()) != nullptr) {
+    // One transmission at a time; the next waits in the queue until the radio is done with this one
+    if ((pCommand->type == RfCommandTransmit) && (this->rfState_ != RfStateIdle)) {
+      break;
+    }
+
+    this->rfExecute(*pCommand);
+    this->rfCommands_.pop();
+  }
+
+  this->rfHandler();
+}
+
+void ZehnderRF::rfExecute(const RfCommand &command) {
+  nrf905::Config rfConfig;
+
+  switch (command.type) {
+    case RfCommandTransmit:
+      this->rfSeq_ = command.seq;
+      this->retries_ = command.retries;
+
+      this->rfTxStartAt_ = 0;
+      this->rfTxDoneAt_ = 0;
+      this->rfTimingSeq_ = command.seq;
+
+      // Reply window from the round trips measured to the addressee; broadcasts are answered by the main unit
+      this->txPeer_ = this->rfPeer(command.frame[0],
+                                   command.frame[1] == 0x00 ? this->config_.fan_main_unit_id : command.frame[1]);
+      this->txAttempt_ = 0;
+      this->replyTimeout_ = this->rfPeerTimeout(this->txPeer_);
+      this->retryDelay_ = 0;
+
+      // Loaded onto the chip once the airway is free, together with the rest of the transmit setup
+      memcpy(this->rfTxFrame_, command.frame, FAN_FRAMESIZE);
+
+      this->rfState_ = RfStateWaitAirwayFree;
+      this->airwayFreeWaitTime_ = millis();
+      break;
+
+    case RfCommandComplete:
+      if (command.seq != this->rfSeq_) {
+        break;
+      }
+
+      // Only a reply to the first attempt is a clean sample; a retry's reply may answer an earlier copy (Karn)
+      if ((this->retries_ >= 0) && (this->rfState_ == RfStateRxWait) && (this->txAttempt_ == 0) &&
+          (this->txPeer_ != NULL) && ((int32_t) (command.time - this->msgSendTime_) >= 0)) {
+        this->rfPeerSample(this->txPeer_, command.time - this->msgSendTime_);
+      }
+      // Fall through
+
+    case RfCommandCancel:
+      if (command.seq != this->rfSeq_) {
+        break;
+      }
+
+      this->retries_ = -1;  // Disable this->retries_
+      // A transmission on air finishes, TX ready then finds nothing to wait for
+      if (this->rfState_ != RfStateTxBusy) {
+        this->rfState_ = RfStateIdle;
+      }
+      break;
+
+    case RfCommandSetAddress:
+      this->rf_->beginBatch();
+      rfConfig = this->rf_->getConfig();
+      rfConfig.rx_address = command.address;
+      this->rf_->updateConfig(&rfConfig, NULL);
+      this->rf_->writeTxAddress(command.address, NULL);
+      this->rf_->endBatch();
+      break;
+
+    case RfCommandSetMode:
+      if (this->rfState_ == RfStateIdle) {
+        this->rf_->setMode(command.mode);
+      } else {
+        // E.g. a reply handled while a retry was on air; the protocol side asks again once the radio is done
+        this->rfEvent(RfEventModeDropped);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void ZehnderRF::rfEvent(const RfEventType type) {
+  if (!this->rfEvents_.push({type, this->rfSeq_})) {
+    this->rfEventOverflows_.fetch_add(1, std::memory_order_relaxed);
+    ESP_LOGE(TAG, "RF event queue full, event %u dropped", type);
+  }
+}
+
 void ZehnderRF::rfHandler(void) {
   switch (this->rfState_) {
     case RfStateIdle:
       break;
 
     case RfStateWaitAirwayFree:
-      if ((millis() - this->airwayFreeWaitTime_) > 5000) {
+      if ((millis() - this->airwayFreeWaitTime_) < this->retryDelay_) {
+        // Backing off before a retry
+      } else if ((millis() - this->airwayFreeWaitTime_) > (this->retryDelay_ + 5000)) {
         ESP_LOGW(TAG, "RF airway too busy, transmission timeout");
         this->rfState_ = RfStateIdle;
-
-        if (this->onReceiveTimeout_ != NULL) {
-          this->onReceiveTimeout_();
-        }
+        this->rfEvent(RfEventTimeout);
+      } else if (this->rf_->getMode() != nrf905::Receive) {
+        // Radio was put to sleep; listen first, carrier detect is only valid in receive mode
+        this->rf_->setMode(nrf905::Receive);
+      } else if (this->rf_->getTransition() != nrf905::Settled) {
+        // Wait for the receiver to come up before checking the airway
       } else if (this->rf_->airwayBusy() == false) {
         ESP_LOGD(TAG, "Starting RF transmission");
+        // Payload (skipped by the driver when the chip still holds this frame, e.g. retries and repeated polls),
+        // retransmit flag and the switch to TX in one standby round trip
+        this->rf_->beginBatch();
+        this->rf_->writeTxPayload(this->rfTxFrame_, FAN_FRAMESIZE);
         this->rf_->startTx(FAN_TX_FRAMES, nrf905::Receive);  // After transmit, wait for response
+        this->rf_->endBatch();
+        if (this->rfTxStartAt_ == 0) {
+          this->rfTxStartAt_ = millis();
+        }
 
         this->rfState_ = RfStateTxBusy;
       }
@@ -686,12 +1171,23 @@ void ZehnderRF::rfHandler(void) {
       break;
 
     case RfStateRxWait:
-      if ((this->retries_ >= 0) && ((millis() - this->msgSendTime_) > FAN_REPLY_TIMEOUT)) {
-        ESP_LOGD(TAG, "Receive timeout");
+      // A frame that came in within the window may be the reply; wait until the protocol side has had a look
+      if ((this->retries_ >= 0) && ((millis() - this->msgSendTime_) > this->replyTimeout_) &&
+          (this->rf_->getRxPending() == 0)) {
+        ESP_LOGD(TAG, "Receive timeout after %u ms", this->replyTimeout_);
 
         if (this->retries_ > 0) {
           --this->retries_;
-          ESP_LOGD(TAG, "No response received, retrying (%u attempts remaining)", this->retries_);
+          ++this->txAttempt_;
+
+          // Longer windows for a peer that did not answer in time, and a growing pause so retries do not
+          // hammer a busy channel; the random half keeps devices that collided from colliding again
+          this->replyTimeout_ = std::min<uint32_t>(this->replyTimeout_ * 2, FAN_REPLY_TIMEOUT);
+          this->retryDelay_ = std::min<uint32_t>(FAN_RETRY_BACKOFF << std::min<uint8_t>(this->txAttempt_ - 1, 8),
+                                                 FAN_RETRY_BACKOFF_MAX);
+          this->retryDelay_ = this->retryDelay_ / 2 + (random_uint32() % (this->retryDelay_ / 2 + 1));
+          ESP_LOGD(TAG, "No response received, retrying in %u ms (%u attempts remaining)", this->retryDelay_,
+                   this->retries_);
 
           this->rfState_ = RfStateWaitAirwayFree;
           this->airwayFreeWaitTime_ = millis();
@@ -699,12 +1195,10 @@ void ZehnderRF::rfHandler(void) {
           // Oh oh, ran out of options
 
           ESP_LOGD(TAG, "No response received after all retries, giving up");
-          if (this->onReceiveTimeout_ != NULL) {
-            this->onReceiveTimeout_();
-          }
 
           // Back to idle
           this->rfState_ = RfStateIdle;
+          this->rfEvent(RfEventTimeout);
         }
       }
       break;
@@ -714,6 +1208,118 @@ void ZehnderRF::rfHandler(void) {
   }
 }
 
+bool ZehnderRF::rfIsDuplicate(const RfFrame &frame) {
+  uint32_t hash = 2166136261UL;  // FNV-1a
+  RfSeenFrame *pSeen;
+
+  hash = (hash ^ frame.rx_type) * 16777619UL;
+  hash = (hash ^ frame.rx_id) * 16777619UL;
+  hash = (hash ^ frame.parameter_count) * 16777619UL;
+  for (uint8_t i = 0; i < frame.parameter_count; ++i) {
+    hash = (hash ^ frame.parameters[i]) * 16777619UL;
+  }
+
+  // Direct mapped, so a lookup is a single compare; a colliding frame just evicts the older one
+  pSeen = &this->dedupCache_[(hash ^ frame.tx_id ^ frame.command) & (FAN_DEDUP_ENTRIES - 1)];
+  if (pSeen->valid && (pSeen->hash == hash) && (pSeen->txType == frame.tx_type) && (pSeen->txId == frame.tx_id) &&
+      (pSeen->command == frame.command) && ((millis() - pSeen->lastSeen) <= FAN_DEDUP_WINDOW)) {
+    // Copies follow each other back to back, so the window runs from the latest one
+    pSeen->lastSeen = millis();
+    ++this->dedupHits_;
+
+    return true;
+  }
+
+  pSeen->txType = frame.tx_type;
+  pSeen->txId = frame.tx_id;
+  pSeen->command = frame.command;
+  pSeen->valid = true;
+  pSeen->hash = hash;
+  pSeen->lastSeen = millis();
+  ++this->dedupMisses_;
+
+  return false;
+}
+
+ZehnderRF::RfPeer *ZehnderRF::rfPeer(const uint8_t type, const uint8_t id) {
+  RfPeer *pPeer = &this->rfPeers_[0];
+
+  for (uint8_t i = 0; i < FAN_RTT_PEERS; ++i) {
+    if ((this->rfPeers_[i].type == type) && (this->rfPeers_[i].id == id)) {
+      pPeer = &this->rfPeers_[i];
+      break;
+    }
+    // Else make room by forgetting the peer we have not talked to for the longest
+    if ((millis() - this->rfPeers_[i].lastUsed) > (millis() - pPeer->lastUsed)) {
+      pPeer = &this->rfPeers_[i];
+    }
+  }
+
+  if ((pPeer->type != type) || (pPeer->id != id)) {
+    pPeer->type = type;
+    pPeer->id = id;
+    pPeer->samples = 0;
+    pPeer->srtt = 0;
+    pPeer->rttvar = 0;
+  }
+  pPeer->lastUsed = millis();
+
+  return pPeer;
+}
+
+void ZehnderRF::rfPeerSample(RfPeer *const pPeer, const uint32_t rtt) {
+  const uint32_t sample = std::min<uint32_t>(rtt, FAN_REPLY_TIMEOUT) * 8;
+  uint32_t delta;
+
+  if (pPeer->samples == 0) {
+    pPeer->srtt = sample;
+    pPeer->rttvar = sample / 2;
+  } else {
+    delta = (pPeer->srtt > sample) ? (pPeer->srtt - sample) : (sample - pPeer->srtt);
+    pPeer->rttvar = pPeer->rttvar - (pPeer->rttvar / 4) + (delta / 4);
+    pPeer->srtt = pPeer->srtt - (pPeer->srtt / 8) + (sample / 8);
+  }
+  if (pPeer->samples < 0xFFFF) {
+    ++pPeer->samples;
+  }
+
+  ESP_LOGV(TAG, "Reply from 0x%02X after %u ms, srtt %u ms, rttvar %u ms, timeout %u ms", pPeer->id, rtt,
+           pPeer->srtt / 8, pPeer->rttvar / 8, this->rfPeerTimeout(pPeer));
+}
+
+uint32_t ZehnderRF::rfPeerTimeout(const RfPeer *const pPeer) {
+  uint32_t timeout;
+
+  if ((pPeer == NULL) || (pPeer->samples == 0)) {
+    return FAN_REPLY_TIMEOUT;
+  }
+
+  timeout = (pPeer->srtt + std::max<uint32_t>(FAN_RTT_GRANULARITY * 8, pPeer->rttvar * 4)) / 8;
+
+  return std::max<uint32_t>(FAN_REPLY_TIMEOUT_MIN, std::min<uint32_t>(timeout, FAN_REPLY_TIMEOUT));
+}
+
+uint32_t ZehnderRF::getReplyRtt(void) {
+  for (const RfPeer &peer : this->rfPeers_) {
+    if ((peer.type == this->config_.fan_main_unit_type) && (peer.id == this->config_.fan_main_unit_id) &&
+        (peer.samples > 0)) {
+      return peer.srtt / 8;
+    }
+  }
+
+  return 0;
+}
+
+uint32_t ZehnderRF::getReplyTimeout(void) {
+  for (const RfPeer &peer : this->rfPeers_) {
+    if ((peer.type == this->config_.fan_main_unit_type) && (peer.id == this->config_.fan_main_unit_id)) {
+      return this->rfPeerTimeout(&peer);
+    }
+  }
+
+  return FAN_REPLY_TIMEOUT;
+}
+
 void ZehnderRF::update_connection_status(bool success) {
   if (success) {
     this->last_successful_communication_ = millis();
@@ -739,7 +1345,7 @@ void ZehnderRF::update_connection_status(bool success) {
 void ZehnderRF::check_connection_health() {
   // If we haven't had successful communication in too long, mark as unhealthy
   // Allow some grace time beyond the normal query interval
-  uint32_t health_timeout = this->interval_ * 5; // 5x the query interval
+  uint32_t health_timeout = std::max(this->interval_, this->pollDelay_) * 5; // 5x the query interval
   
   if (this->connection_healthy_ && this->last_successful_communication_ != 0) {
     if ((millis() - this->last_successful_communication_) > health_timeout) {
@@ -6,42 +6,39 @@
 #include "esphome/components/spi/spi.h"
 #include "esphome/components/fan/fan.h"
 #include "esphome/components/nrf905/nRF905.h"
+#include "zehnder_frame.h"
+#include "zehnder_latency.h"
+#include "zehnder_queue.h"
+
+#ifdef USE_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
 
 namespace esphome {
 namespace zehnder {
 
-#define FAN_FRAMESIZE 16        // Each frame consists of 16 bytes
 #define FAN_TX_FRAMES 4         // Retransmit every transmitted frame 4 times
 #define FAN_TX_RETRIES 10       // Retry transmission 10 times if no reply is received
-#define FAN_TTL 250             // 0xFA, default time-to-live for a frame
-#define FAN_REPLY_TIMEOUT 1000  // Wait 500ms for receiving a reply when doing a network scan
-
-/* Fan device types */
-// Ref: https://github.com/eelcohn/ZehnderComfoair#transmitter-and-receiver-types
-enum {
-  FAN_TYPE_BROADCAST = 0x00,            // Broadcast to all devices
-  FAN_TYPE_MAIN_UNIT = 0x01,            // Fans
-  FAN_TYPE_REMOTE_CONTROL = 0x03,       // Remote controls
-  FAN_TYPE_TIMER_REMOTE_CONTROL = 0x16, // Timer RF remote control. The one with 10/30/60/timer off buttons
-  FAN_TYPE_CO2_SENSOR = 0x18
-};  // CO2 sensors
-
-/* Fan commands */
-enum {
-  FAN_FRAME_SETVOLTAGE = 0x01,  // Set speed (voltage / percentage)
-  FAN_FRAME_SETSPEED = 0x02,    // Set speed (preset)
-  FAN_FRAME_SETTIMER = 0x03,    // Set speed with timer
-  FAN_NETWORK_JOIN_REQUEST = 0x04,
-  FAN_FRAME_SETSPEED_REPLY = 0x05,
-  FAN_NETWORK_JOIN_OPEN = 0x06,
-  FAN_TYPE_FAN_SETTINGS = 0x07,  // Current settings, sent by fan in reply to 0x01, 0x02, 0x10
-  FAN_FRAME_0B = 0x0B,
-  FAN_NETWORK_JOIN_ACK = 0x0C,
-  // FAN_NETWORK_JOIN_FINISH = 0x0D,
-  FAN_TYPE_QUERY_NETWORK = 0x0D,
-  FAN_TYPE_QUERY_DEVICE = 0x10,
-  FAN_FRAME_SETVOLTAGE_REPLY = 0x1D
-};
+#define FAN_REPLY_TIMEOUT 1000  // Longest reply window, also used for a peer without RTT samples yet
+#define FAN_REPLY_TIMEOUT_MIN 50  // Shortest reply window, whatever the measured round trip
+#define FAN_RTT_GRANULARITY 10    // Slack on top of the smoothed RTT for the loop and the ms clock
+#define FAN_RTT_PEERS 2           // Peers with their own RTT estimate
+#define FAN_RETRY_BACKOFF 25       // Pause before the first retry, doubled on every further retry
+#define FAN_RETRY_BACKOFF_MAX 500  // Longest pause between retries
+
+#define FAN_DEDUP_ENTRIES 8   // Frames remembered to drop repeated copies, a power of 2
+#define FAN_DEDUP_WINDOW 100  // A copy within this many ms of the previous one is a repeat
+
+#define FAN_RF_COMMANDS 8           // Requests from the protocol to the RF engine, a power of 2
+#define FAN_RF_EVENTS 4             // Results from the RF engine to the protocol, a power of 2
+#define FAN_RF_TASK_STACK 4096      // Bytes
+#define FAN_RF_TASK_PRIORITY 10     // Above the ESPHome loop task, below the Wi-Fi and lwIP tasks
+#define FAN_COMMAND_MAX_AGE 10000  // Drop a user command that could not be sent within 10 s
+
+#define FAN_POLL_FAST_COUNT 2     // Polls at the minimum interval after a speed command
+#define FAN_POLL_BACKOFF_AFTER 3  // Polls without a change before the interval starts doubling
+#define FAN_POLL_JITTER 10        // Random +/- percentage on every poll interval
 
 /* Fan speed presets */
 enum {
@@ -58,6 +55,9 @@ enum {
 
 typedef enum { ResultOk, ResultBusy, ResultFailure } Result;
 
+// Called when no reply came in time; held inline, so each transmission sets it without touching the heap
+typedef nrf905::Delegate<void(void)> TimeoutCallback;
+
 class ZehnderRF : public Component, public fan::Fan {
  public:
   ZehnderRF();
@@ -67,7 +67,19 @@ class ZehnderRF : public Component, public fan::Fan {
   // Setup things
   void set_rf(nrf905::nRF905 *const pRf) { rf_ = pRf; }
 
-  void set_update_interval(const uint32_t interval) { interval_ = interval; }
+  void set_update_interval(const uint32_t interval) {
+    interval_ = interval;
+    pollDelay_ = interval;
+  }
+  void set_update_interval_min(const uint32_t interval) { intervalMin_ = interval; }
+  void set_update_interval_max(const uint32_t interval) { intervalMax_ = interval; }
+  void set_radio_idle_mode(const nrf905::Mode mode) { radioIdleMode_ = mode; }
+  void set_command_max_age(const uint32_t maxAge) { commandMaxAge_ = maxAge; }
+  void set_passive_tracking(const bool enable) { passiveTracking_ = enable; }
+  void set_publish_min_interval(const uint32_t interval) { publishMinInterval_ = interval; }
+  void set_publish_heartbeat(const uint32_t interval) { publishHeartbeat_ = interval; }
+  void set_rf_task(const bool enable) { rfTask_ = enable; }
+  void set_rf_task_core(const uint8_t core) { rfTaskCore_ = core; }
 
   void dump_config() override;
   void set_config(const uint32_t fan_networkId,
@@ -85,25 +97,113 @@ class ZehnderRF : public Component, public fan::Fan {
 
   float get_setup_priority() const override { return setup_priority::DATA; }
 
+  // Queued; sent right away when the fan is idle, else as soon as it is
   void setSpeed(const uint8_t speed, const uint8_t timer = 0);
 
-  bool timer;
-  int voltage;
+  bool timer{false};
+  int voltage{0};
 
   // Connection health status (public for template sensors)
   bool connection_healthy_{true};
 
+  // Reply round trip to the main unit; 0 until measured (for template sensors)
+  uint32_t getReplyRtt(void);
+  uint32_t getReplyTimeout(void);
+
+  // Received frames handled and repeated copies dropped
+  uint32_t getRxFrameCount(void) { return this->dedupMisses_; }
+  uint32_t getRxDuplicateCount(void) { return this->dedupHits_; }
+
+  // State publishes sent and skipped because nothing changed or they came too soon after the previous one
+  uint32_t getPublishCount(void) { return this->publishesEmitted_; }
+  uint32_t getPublishSuppressedCount(void) { return this->publishesSuppressed_; }
+
+  // Commands to and events from the RF engine dropped because its queue was full; 0 while the engine keeps up
+  uint32_t getRfCommandOverflowCount(void) { return this->rfCommandOverflows_.load(std::memory_order_relaxed); }
+  uint32_t getRfEventOverflowCount(void) { return this->rfEventOverflows_.load(std::memory_order_relaxed); }
+
+  // End to end latency in ms, from a speed command being queued until the fan confirmed it, and from a poll being
+  // queued until its reply; percentile (0 - 100) of those seen so far, 0 until there are any
+  uint32_t getCommandLatency(const uint8_t percentile);
+  uint32_t getQueryLatency(const uint8_t percentile);
+
  protected:
   void queryDevice(void);
+  void sendSpeed(const uint8_t speed, const uint8_t timer);
+
+  bool applyFanSettings(const RfPayloadFanSettings &settings);
+  void schedulePoll(const bool changed);
+  bool trackFanSettings(const RfFrame &frame);
+  void publishSettings(const bool force);
+
+  void buildFrameTemplates(void);
 
   uint8_t createDeviceID(void);
   void discoveryStart(const uint8_t deviceId);
 
   Result startTransmit(const uint8_t *const pData, const int8_t rxRetries = -1,
-                       const std::function<void(void)> callback = NULL);
+                       const TimeoutCallback callback = NULL);
   void rfComplete(void);
+  void rfCancel(void);
+  void rfSetAddress(const uint32_t address);
+  void rfSetIdleMode(const nrf905::Mode mode);
+  void rfHandleEvents(void);
+
+  // RF engine: the transmit/retry state machine and the radio driver. Runs from loop(), or with rf_task in a
+  // task of its own; the protocol side only talks to it through the queues below, so both work the same
+  typedef enum {
+    RfCommandTransmit,    // Send frame, wait for a reply if retries >= 0
+    RfCommandComplete,    // Reply received, stop retrying
+    RfCommandCancel,      // Give up on the transmission, no event follows
+    RfCommandSetAddress,  // RX and TX address
+    RfCommandSetMode,     // Radio mode while nothing is going on
+  } RfCommandType;
+
+  typedef struct {
+    RfCommandType type;
+    uint8_t seq;  // Transmission this belongs to
+    int8_t retries;
+    nrf905::Mode mode;
+    uint32_t address;
+    uint32_t time;  // Complete: millis() at which the reply was read from the radio
+    uint8_t frame[FAN_FRAMESIZE];
+  } RfCommand;
+
+  typedef enum {
+    RfEventDone,         // Transmission without reply sent
+    RfEventTimeout,      // No reply after all retries, or the airway stayed busy
+    RfEventModeDropped,  // Idle mode not applied, the radio was still busy with a transmission
+  } RfEventType;
+
+  typedef struct {
+    RfEventType type;
+    uint8_t seq;
+  } RfEvent;
+
+  void rfPost(const RfCommand &command);
+  void rfTaskStep(void);
+  void rfExecute(const RfCommand &command);
+  void rfEvent(const RfEventType type);
   void rfHandler(void);
+#ifdef USE_ESP32
+  static void rfTaskEntry(void *arg);
+#endif
+
+  // Round trip estimate per peer (RFC 6298 SRTT/RTTVAR), values in 1/8 ms
+  typedef struct {
+    uint8_t type;
+    uint8_t id;
+    uint16_t samples;
+    uint32_t srtt;
+    uint32_t rttvar;
+    uint32_t lastUsed;
+  } RfPeer;
+
+  RfPeer *rfPeer(const uint8_t type, const uint8_t id);
+  void rfPeerSample(RfPeer *const pPeer, const uint32_t rtt);
+  uint32_t rfPeerTimeout(const RfPeer *const pPeer);
   void rfHandleReceived(const uint8_t *const pData, const uint8_t dataLength);
+  bool rfIsDuplicate(const RfFrame &frame);
 
   typedef enum {
     StateStartup,
@@ -124,9 +224,15 @@ class ZehnderRF : public Component, public fan::Fan {
 
   nrf905::nRF905 *rf_;
   uint32_t interval_;
+  nrf905::Mode radioIdleMode_{nrf905::Receive};  // Radio mode between the end of a reply window and the next poll
+  bool passiveTracking_{false};  // Follow settings the main unit sends to other devices; needs the radio listening
 
   uint8_t _txFrame[FAN_FRAMESIZE];
 
+  // Frames of the steady-state commands, built whenever the pairing changes
+  uint8_t _queryFrame[FAN_FRAMESIZE]{};
+  uint8_t _setSpeedFrames[FAN_SPEED_MAX + 1][FAN_FRAMESIZE]{};  // Per preset, [0] is auto
+
   ESPPreferenceObject pref_;
 
   typedef struct {
@@ -139,15 +245,136 @@ class ZehnderRF : public Component, public fan::Fan {
   Config config_;
 
   uint32_t lastFanQuery_{0};
-  std::function<void(void)> onReceiveTimeout_ = NULL;
 
+  // Adaptive polling: fast after a command or while a timer runs, backing off while nothing changes
+  uint32_t intervalMin_{10000};
+  uint32_t intervalMax_{300000};
+  uint32_t pollDelay_{0};      // Time from lastFanQuery_ to the next poll
+  uint8_t unchangedPolls_{0};  // Consecutive poll replies without a change
+  uint8_t fastPolls_{0};       // Polls left at the minimum interval
+
+  // Last state sent to the frontend; only changes are published, no more often than the minimum interval
+  typedef struct {
+    bool valid;
+    bool state;
+    int speed;
+    bool timer;
+    int voltage;
+  } Published;
+  Published published_{};
+  uint32_t lastPublish_{0};
+  uint32_t publishMinInterval_{0};  // 0 publishes every change right away
+  uint32_t publishHeartbeat_{0};    // Republish unchanged state this often, 0 for never
+  bool publishPending_{false};      // A change waits for the minimum interval
+  uint32_t publishesEmitted_{0};
+  uint32_t publishesSuppressed_{0};
+
+  // Protocol side of the RF engine
+  TimeoutCallback onReceiveTimeout_{NULL};
+  uint8_t txSeq_{0};          // Sequence number of the latest transmission
+  bool rfBusy_{false};        // Waiting for the engine to finish it
+  bool radioIdle_{false};     // Idle mode asked for since the last transmission, cleared if the engine dropped it
+  uint32_t rxTimestamp_{0};   // Of the frame being handled
+
+  RfQueue<RfCommand, FAN_RF_COMMANDS> rfCommands_;
+  RfQueue<RfEvent, FAN_RF_EVENTS> rfEvents_;
+  // Queue overflows, one counter per writing side, read from the main loop
+  std::atomic<uint32_t> rfCommandOverflows_{0};
+  std::atomic<uint32_t> rfEventOverflows_{0};
+
+  bool rfTask_{false};
+  uint8_t rfTaskCore_{1};
+#ifdef USE_ESP32
+  TaskHandle_t rfTaskHandle_{NULL};
+#endif
+
+  // Engine side
+  uint8_t rfSeq_{0};
+  uint8_t rfTxFrame_[FAN_FRAMESIZE]{};  // Frame of the transmission in progress
   uint32_t msgSendTime_{0};
   uint32_t airwayFreeWaitTime_{0};
   int8_t retries_{-1};
 
-  uint8_t newSpeed{0};
-  uint8_t newTimer{0};
-  bool newSetting{false};
+  // Lifecycle of the transmission in progress, for the latency histograms; 0 until it happened
+  std::atomic<uint8_t> rfTimingSeq_{0};
+  std::atomic<uint32_t> rfTxStartAt_{0};  // First copy on air, after waiting for the airway
+  std::atomic<uint32_t> rfTxDoneAt_{0};   // Last attempt sent
+
+  // Recently received frames; every frame is sent FAN_TX_FRAMES times, only the first copy is handled
+  typedef struct {
+    uint8_t txType;
+    uint8_t txId;
+    uint8_t command;
+    bool valid;
+    uint32_t hash;  // Of the destination and the parameters
+    uint32_t lastSeen;
+  } RfSeenFrame;
+  RfSeenFrame dedupCache_[FAN_DEDUP_ENTRIES]{};
+  uint32_t dedupHits_{0};
+  uint32_t dedupMisses_{0};
+
+  RfPeer rfPeers_[FAN_RTT_PEERS]{};
+  RfPeer *txPeer_{NULL};      // Peer the transmission in progress waits for
+  uint8_t txAttempt_{0};      // 0 for the first attempt, counts retries
+  uint32_t replyTimeout_{0};  // Reply window of the current attempt
+  uint32_t retryDelay_{0};    // Backoff before the current attempt goes on air
+
+  // Commands waiting for the fan to be idle; in priority order, user commands before polls
+  typedef enum {
+    CommandSetSpeed,
+    CommandQuery,
+
+    CommandNrOf  // Keep last
+  } CommandType;
+
+  typedef struct {
+    CommandType type;
+    uint8_t speed;
+    uint8_t timer;
+    uint32_t queuedAt;       // millis() of the latest request
+    uint32_t firstQueuedAt;  // millis() of the first request, kept when a later one replaces it
+    uint32_t maxAge;         // ms after queuedAt when it is stale and dropped
+  } Command;
+
+  void queueCommand(const CommandType type, const uint8_t speed, const uint8_t timer, const uint32_t maxAge);
+  bool takeCommand(Command *const pCommand);
+  bool userCommandPending(void);
+  void processCommands(void);
+
+  // A newer command replaces a pending one of the same type, so there is at most one entry per type
+  Command commandQueue_[CommandNrOf];
+  uint8_t commandCount_{0};
+  uint32_t commandMaxAge_{FAN_COMMAND_MAX_AGE};
+  uint32_t commandsDropped_{0};
+
+  // Stages a command or poll goes through; a poll ends with its reply, so it has no confirm stage
+  typedef enum {
+    LatencyWait,      // Queued until the first copy is on air: queue, RF engine and airway free wait
+    LatencyTransmit,  // First copy on air until the last attempt is sent, retries included
+    LatencyReply,     // Last attempt sent until the reply came in
+    LatencyConfirm,   // Reply until the confirmation to the fan is sent
+    LatencyTotal,
+
+    LatencyNrOf  // Keep last
+  } LatencyStage;
+
+  typedef struct {
+    bool active;
+    CommandType type;
+    uint8_t seq;  // Of its transmission
+    uint32_t queuedAt;
+    uint32_t txStartAt;
+    uint32_t txDoneAt;
+    uint32_t replyAt;
+  } LatencyTrace;
+
+  void latencyStart(const Command &command);
+  void latencyReply(void);
+  void latencyFinish(void);
+  void dumpLatency(const char *const name, const CommandType type);
+
+  LatencyTrace latencyTrace_{};
+  LatencyHistogram latency_[CommandNrOf][LatencyNrOf];
 
   typedef enum {
     RfStateIdle,            // Idle state
@@ -155,7 +382,7 @@ class ZehnderRF : public Component, public fan::Fan {
     RfStateTxBusy,          //
     RfStateRxWait,
   } RfState;
-  RfState rfState_{RfStateIdle};
+  std::atomic<RfState> rfState_{RfStateIdle};  // Read by the protocol side
 
   // Private connection health tracking variables
   uint32_t last_successful_communication_{0};
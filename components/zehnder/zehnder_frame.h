@@ -0,0 +1,231 @@
+#ifndef __COMPONENT_ZEHNDER_FRAME_H__
+#define __COMPONENT_ZEHNDER_FRAME_H__
+
+#include <cstdint>
+
+namespace esphome {
+namespace zehnder {
+
+#define FAN_FRAMESIZE 16            // Each frame consists of 16 bytes
+#define FAN_FRAME_HEADER_SIZE 7     // Addressing, TTL, command and parameter count
+#define FAN_FRAME_PARAMETERS_MAX 9  // Parameter bytes following the header
+#define FAN_TTL 250                 // 0xFA, default time-to-live for a frame
+
+static_assert(FAN_FRAME_HEADER_SIZE + FAN_FRAME_PARAMETERS_MAX == FAN_FRAMESIZE, "Frame layout does not add up");
+
+/* Fan device types */
+// Ref: https://github.com/eelcohn/ZehnderComfoair#transmitter-and-receiver-types
+enum {
+  FAN_TYPE_BROADCAST = 0x00,            // Broadcast to all devices
+  FAN_TYPE_MAIN_UNIT = 0x01,            // Fans
+  FAN_TYPE_REMOTE_CONTROL = 0x03,       // Remote controls
+  FAN_TYPE_TIMER_REMOTE_CONTROL = 0x16, // Timer RF remote control. The one with 10/30/60/timer off buttons
+  FAN_TYPE_CO2_SENSOR = 0x18
+};  // CO2 sensors
+
+/* Fan commands */
+enum {
+  FAN_FRAME_SETVOLTAGE = 0x01,  // Set speed (voltage / percentage)
+  FAN_FRAME_SETSPEED = 0x02,    // Set speed (preset)
+  FAN_FRAME_SETTIMER = 0x03,    // Set speed with timer
+  FAN_NETWORK_JOIN_REQUEST = 0x04,
+  FAN_FRAME_SETSPEED_REPLY = 0x05,
+  FAN_NETWORK_JOIN_OPEN = 0x06,
+  FAN_TYPE_FAN_SETTINGS = 0x07,  // Current settings, sent by fan in reply to 0x01, 0x02, 0x10
+  FAN_FRAME_0B = 0x0B,
+  FAN_NETWORK_JOIN_ACK = 0x0C,
+  // FAN_NETWORK_JOIN_FINISH = 0x0D,
+  FAN_TYPE_QUERY_NETWORK = 0x0D,
+  FAN_TYPE_QUERY_DEVICE = 0x10,
+  FAN_FRAME_SETVOLTAGE_REPLY = 0x1D
+};
+
+#define FAN_FRAME_PARAMETERS_ANY -1  // Layout unknown, only the frame bound is checked
+
+// Parameter count each command must carry. Commands whose parameters are decoded are checked exactly, so a
+// truncated payload never reaches the state machine
+constexpr int8_t rfFrameParameterCount(const uint8_t command) {
+  switch (command) {
+    case FAN_FRAME_SETSPEED:
+      return 1;
+    case FAN_FRAME_SETTIMER:
+      return 2;
+    case FAN_NETWORK_JOIN_REQUEST:
+    case FAN_NETWORK_JOIN_OPEN:
+    case FAN_NETWORK_JOIN_ACK:
+      return 4;
+    case FAN_TYPE_FAN_SETTINGS:
+      return 3;
+    case FAN_TYPE_QUERY_DEVICE:
+      return 0;
+    default:
+      return FAN_FRAME_PARAMETERS_ANY;
+  }
+}
+
+// Multi-byte parameters are little endian on air, whatever the host is
+constexpr uint32_t rfGetLe32(const uint8_t *const pData) {
+  return (uint32_t) pData[0] | ((uint32_t) pData[1] << 8) | ((uint32_t) pData[2] << 16) | ((uint32_t) pData[3] << 24);
+}
+
+constexpr void rfPutLe32(uint8_t *const pData, const uint32_t value) {
+  pData[0] = (uint8_t) value;
+  pData[1] = (uint8_t) (value >> 8);
+  pData[2] = (uint8_t) (value >> 16);
+  pData[3] = (uint8_t) (value >> 24);
+}
+
+/* Payloads; each knows its command, its size and where its fields sit in the parameter bytes */
+struct RfPayloadFanSetSpeed {
+  static constexpr uint8_t COMMAND = FAN_FRAME_SETSPEED;
+  static constexpr uint8_t PARAMETER_COUNT = 1;
+  uint8_t speed;
+
+  constexpr void encode(uint8_t *const pParameters) const { pParameters[0] = this->speed; }
+  static constexpr RfPayloadFanSetSpeed decode(const uint8_t *const pParameters) { return {pParameters[0]}; }
+};
+
+struct RfPayloadFanSetTimer {
+  static constexpr uint8_t COMMAND = FAN_FRAME_SETTIMER;
+  static constexpr uint8_t PARAMETER_COUNT = 2;
+  uint8_t speed;
+  uint8_t timer;  // Minutes
+
+  constexpr void encode(uint8_t *const pParameters) const {
+    pParameters[0] = this->speed;
+    pParameters[1] = this->timer;
+  }
+  static constexpr RfPayloadFanSetTimer decode(const uint8_t *const pParameters) {
+    return {pParameters[0], pParameters[1]};
+  }
+};
+
+struct RfPayloadFanSettings {
+  static constexpr uint8_t COMMAND = FAN_TYPE_FAN_SETTINGS;
+  static constexpr uint8_t PARAMETER_COUNT = 3;
+  uint8_t speed;
+  uint8_t voltage;
+  uint8_t timer;
+
+  constexpr void encode(uint8_t *const pParameters) const {
+    pParameters[0] = this->speed;
+    pParameters[1] = this->voltage;
+    pParameters[2] = this->timer;
+  }
+  static constexpr RfPayloadFanSettings decode(const uint8_t *const pParameters) {
+    return {pParameters[0], pParameters[1], pParameters[2]};
+  }
+};
+
+// Join frames only differ in command: JOIN_ACK announces us, JOIN_OPEN is the main unit's offer, JOIN_REQUEST accepts it
+template<uint8_t Command> struct RfPayloadNetwork {
+  static constexpr uint8_t COMMAND = Command;
+  static constexpr uint8_t PARAMETER_COUNT = 4;
+  uint32_t networkId;
+
+  constexpr void encode(uint8_t *const pParameters) const { rfPutLe32(pParameters, this->networkId); }
+  static constexpr RfPayloadNetwork decode(const uint8_t *const pParameters) { return {rfGetLe32(pParameters)}; }
+};
+typedef RfPayloadNetwork<FAN_NETWORK_JOIN_ACK> RfPayloadNetworkJoinAck;
+typedef RfPayloadNetwork<FAN_NETWORK_JOIN_OPEN> RfPayloadNetworkJoinOpen;
+typedef RfPayloadNetwork<FAN_NETWORK_JOIN_REQUEST> RfPayloadNetworkJoinRequest;
+
+// Commands without parameters we send
+template<uint8_t Command> struct RfPayloadEmpty {
+  static constexpr uint8_t COMMAND = Command;
+  static constexpr uint8_t PARAMETER_COUNT = 0;
+
+  constexpr void encode(uint8_t *const /*pParameters*/) const {}
+  static constexpr RfPayloadEmpty decode(const uint8_t *const /*pParameters*/) { return {}; }
+};
+typedef RfPayloadEmpty<FAN_TYPE_QUERY_DEVICE> RfPayloadQueryDevice;
+typedef RfPayloadEmpty<FAN_FRAME_0B> RfPayloadLinkSuccess;  // 0x0B acknowledge link successful
+
+// Meaning of the parameters unknown, sent as captured from a real remote
+struct RfPayloadSetSpeedReply {
+  static constexpr uint8_t COMMAND = FAN_FRAME_SETSPEED_REPLY;
+  static constexpr uint8_t PARAMETER_COUNT = 3;
+
+  constexpr void encode(uint8_t *const pParameters) const {
+    pParameters[0] = 0x54;
+    pParameters[1] = 0x03;
+    pParameters[2] = 0x20;
+  }
+};
+
+/* Addressing of a frame */
+typedef struct {
+  uint8_t rx_type;  // 0x00 RX Type
+  uint8_t rx_id;    // 0x01 RX ID
+  uint8_t tx_type;  // 0x02 TX Type
+  uint8_t tx_id;    // 0x03 TX ID
+} RfAddress;
+
+// Build a complete frame, unused parameter bytes cleared
+template<typename Payload>
+constexpr void rfFrameEncode(uint8_t *const pFrame, const RfAddress &address, const Payload &payload) {
+  static_assert(Payload::PARAMETER_COUNT <= FAN_FRAME_PARAMETERS_MAX, "Payload does not fit in a frame");
+  static_assert((rfFrameParameterCount(Payload::COMMAND) == FAN_FRAME_PARAMETERS_ANY) ||
+                    (rfFrameParameterCount(Payload::COMMAND) == Payload::PARAMETER_COUNT),
+                "Payload size does not match its command");
+
+  pFrame[0] = address.rx_type;
+  pFrame[1] = address.rx_id;
+  pFrame[2] = address.tx_type;
+  pFrame[3] = address.tx_id;
+  pFrame[4] = FAN_TTL;
+  pFrame[5] = Payload::COMMAND;
+  pFrame[6] = Payload::PARAMETER_COUNT;
+  for (uint8_t i = FAN_FRAME_HEADER_SIZE; i < FAN_FRAMESIZE; ++i) {
+    pFrame[i] = 0x00;
+  }
+  payload.encode(&pFrame[FAN_FRAME_HEADER_SIZE]);
+}
+
+/* A received frame; parameters point into the receive buffer */
+typedef struct RfFrame {
+  uint8_t rx_type;            // 0x00 RX Type
+  uint8_t rx_id;              // 0x01 RX ID
+  uint8_t tx_type;            // 0x02 TX Type
+  uint8_t tx_id;              // 0x03 TX ID
+  uint8_t ttl;                // 0x04 Time-To-Live
+  uint8_t command;            // 0x05 Frame type
+  uint8_t parameter_count;     // 0x06 Number of parameters
+  const uint8_t *parameters;  // 0x07 - 0x0F Depends on command
+
+  // Only valid for a frame with the payload's command, which rfFrameDecode() checked the size of
+  template<typename Payload> constexpr Payload payload() const { return Payload::decode(this->parameters); }
+} RfFrame;
+
+typedef enum { RfFrameOk, RfFrameTooShort, RfFrameBadParameterCount } RfFrameStatus;
+
+// Split a received frame and check it against the command table in one pass
+constexpr RfFrameStatus rfFrameDecode(const uint8_t *const pData, const uint8_t dataLength, RfFrame *const pFrame) {
+  int8_t expected = FAN_FRAME_PARAMETERS_ANY;
+
+  if (dataLength < FAN_FRAMESIZE) {
+    return RfFrameTooShort;
+  }
+
+  pFrame->rx_type = pData[0];
+  pFrame->rx_id = pData[1];
+  pFrame->tx_type = pData[2];
+  pFrame->tx_id = pData[3];
+  pFrame->ttl = pData[4];
+  pFrame->command = pData[5];
+  pFrame->parameter_count = pData[6];
+  pFrame->parameters = &pData[FAN_FRAME_HEADER_SIZE];
+
+  expected = rfFrameParameterCount(pFrame->command);
+  if ((pFrame->parameter_count > FAN_FRAME_PARAMETERS_MAX) ||
+      ((expected != FAN_FRAME_PARAMETERS_ANY) && (pFrame->parameter_count != expected))) {
+    return RfFrameBadParameterCount;
+  }
+
+  return RfFrameOk;
+}
+
+}  // namespace zehnder
+}  // namespace esphome
+
+#endif /* __COMPONENT_ZEHNDER_FRAME_H__ */
@@ -0,0 +1,97 @@
+#ifndef __COMPONENT_ZEHNDER_LATENCY_H__
+#define __COMPONENT_ZEHNDER_LATENCY_H__
+
+#include <cstdint>
+
+namespace esphome {
+namespace zehnder {
+
+// Fixed bucket latency histogram: exact below 8 ms, then 4 buckets per power of 2 (at most 25% wide) up to ~131 s.
+// Percentiles come from the bucket counts, so no samples are kept and adding one costs a few instructions.
+class LatencyHistogram {
+ public:
+  static const uint8_t BUCKETS = 64;
+  static const uint32_t MAX_VALUE = 131071;
+
+  void add(const uint32_t ms) {
+    const uint8_t bucket = LatencyHistogram::bucket(ms);
+
+    if (this->counts_[bucket] == 0xFFFF) {
+      // Halve everything rather than saturate, recent samples then weigh more than old ones
+      this->count_ = 0;
+      for (uint8_t i = 0; i < BUCKETS; ++i) {
+        this->counts_[i] /= 2;
+        this->count_ += this->counts_[i];
+      }
+    }
+
+    ++this->counts_[bucket];
+    ++this->count_;
+  }
+
+  // Highest value of the bucket the given percentile (0 - 100) falls in; 0 without samples
+  uint32_t percentile(const uint8_t percent) const {
+    uint32_t rank;
+    uint32_t seen = 0;
+
+    if (this->count_ == 0) {
+      return 0;
+    }
+
+    // Nearest rank, 1 based
+    rank = (uint32_t) (((uint64_t) this->count_ * (percent > 100 ? 100 : percent) + 99) / 100);
+    if (rank == 0) {
+      rank = 1;
+    }
+
+    for (uint8_t i = 0; i < BUCKETS; ++i) {
+      seen += this->counts_[i];
+      if (seen >= rank) {
+        return LatencyHistogram::bucketLimit(i);
+      }
+    }
+
+    return MAX_VALUE;
+  }
+
+  uint32_t count(void) const { return this->count_; }
+
+  void clear(void) {
+    for (uint8_t i = 0; i < BUCKETS; ++i) {
+      this->counts_[i] = 0;
+    }
+    this->count_ = 0;
+  }
+
+  static uint8_t bucket(const uint32_t ms) {
+    const uint32_t value = ms > MAX_VALUE ? MAX_VALUE : ms;
+    uint8_t msb;
+
+    if (value < 8) {
+      return (uint8_t) value;
+    }
+
+    msb = 31 - __builtin_clz(value);
+    return 8 + ((msb - 3) * 4) + ((value >> (msb - 2)) & 3);
+  }
+
+  static uint32_t bucketLimit(const uint8_t bucket) {
+    uint8_t shift;
+
+    if (bucket < 8) {
+      return bucket;
+    }
+
+    shift = ((bucket - 8) / 4) + 1;
+    return ((4 + ((bucket - 8) % 4) + 1) << shift) - 1;
+  }
+
+ protected:
+  uint16_t counts_[BUCKETS]{};
+  uint32_t count_{0};
+};
+
+}  // namespace zehnder
+}  // namespace esphome
+
+#endif /* __COMPONENT_ZEHNDER_LATENCY_H__ */
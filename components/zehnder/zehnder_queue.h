@@ -0,0 +1,55 @@
+#ifndef __COMPONENT_ZEHNDER_QUEUE_H__
+#define __COMPONENT_ZEHNDER_QUEUE_H__
+
+#include <atomic>
+#include <cstdint>
+
+namespace esphome {
+namespace zehnder {
+
+// Single producer / single consumer ring, lock free, so the main loop and the RF task never wait on each other.
+// Size must be a power of 2.
+template<typename T, uint8_t Size> class RfQueue {
+  static_assert((Size != 0) && ((Size & (Size - 1)) == 0), "Queue size must be a power of 2");
+
+ public:
+  // Producer side; false when full
+  bool push(const T &item) {
+    const uint8_t head = this->head_.load(std::memory_order_relaxed);
+
+    if ((uint8_t) (head - this->tail_.load(std::memory_order_acquire)) >= Size) {
+      return false;
+    }
+
+    this->items_[head & (Size - 1)] = item;
+    this->head_.store(head + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // Consumer side; the item stays queued until pop(), so it can be left for later
+  T *peek(void) {
+    const uint8_t tail = this->tail_.load(std::memory_order_relaxed);
+
+    if (tail == this->head_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+
+    return &this->items_[tail & (Size - 1)];
+  }
+
+  void pop(void) { this->tail_.store(this->tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  // Only while neither side is running, e.g. from tests
+  void clear(void) { this->tail_.store(this->head_.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+ protected:
+  T items_[Size];
+  std::atomic<uint8_t> head_{0};
+  std::atomic<uint8_t> tail_{0};
+};
+
+}  // namespace zehnder
+}  // namespace esphome
+
+#endif /* __COMPONENT_ZEHNDER_QUEUE_H__ */
@@ -28,6 +28,11 @@ echo "📋 Test 3: ESP-IDF framework compatibility"
 echo "------------------------------------------"
 python3 tests/test_espidf_compatibility.py
 
+echo ""
+echo "📋 Test 4: Native host tests (nRF905 simulator)"
+echo "-----------------------------------------------"
+python3 tests/test_host_build.py
+
 echo ""
 echo "✅ All tests passed!"
 echo ""
@@ -0,0 +1,277 @@
+// Microbenchmarks for the register and frame codecs, on the host with Google Benchmark
+//
+// Each benchmark also reports heap allocations per call ("allocs"); the code runs in the ESPHome main loop of a
+// single core microcontroller, so both time and allocations should stay flat.
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include <benchmark/benchmark.h>
+
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+static std::atomic<uint64_t> allocations{0};
+
+// Every form of operator new and delete goes through this one malloc/free pair. Kept out of line, so the compiler
+// does not see free() on memory from operator new where it inlines a delete
+__attribute__((noinline)) static void *countedAlloc(size_t size, size_t alignment) {
+  void *p;
+
+  ++allocations;
+  if (alignment > alignof(std::max_align_t)) {
+    p = std::aligned_alloc(alignment, ((size + alignment - 1) / alignment) * alignment);
+  } else {
+    p = std::malloc(size != 0 ? size : 1);
+  }
+
+  return p;
+}
+
+__attribute__((noinline)) static void countedFree(void *p) { std::free(p); }
+
+void *operator new(size_t size) {
+  void *p = countedAlloc(size, 0);
+
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return p;
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+  void *p = countedAlloc(size, (size_t) alignment);
+
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new[](size_t size, std::align_val_t alignment) { return operator new(size, alignment); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size, 0); }
+void *operator new[](size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size, 0); }
+
+void operator delete(void *p) noexcept { countedFree(p); }
+void operator delete(void *p, size_t) noexcept { countedFree(p); }
+void operator delete(void *p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void *p, size_t, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void *p) noexcept { countedFree(p); }
+void operator delete[](void *p, size_t) noexcept { countedFree(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { countedFree(p); }
+void operator delete[](void *p, size_t, std::align_val_t) noexcept { countedFree(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { countedFree(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { countedFree(p); }
+
+// Counts the allocations made while the benchmark loop runs
+class AllocationCounter {
+ public:
+  explicit AllocationCounter(benchmark::State &state) : state_(state), start_(allocations.load()) {}
+  ~AllocationCounter() {
+    this->state_.counters["allocs"] =
+        benchmark::Counter((double) (allocations.load() - this->start_), benchmark::Counter::kAvgIterations);
+  }
+
+ protected:
+  benchmark::State &state_;
+  uint64_t start_;
+};
+
+static const uint32_t NETWORK_ID = 0xA1B2C3D4;
+
+// A paired fan on a set up radio, ready for frames
+class PairedFan : public FanBench {
+ public:
+  PairedFan() {
+    this->setup();
+    this->fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, 0x17, zehnder::FAN_TYPE_MAIN_UNIT, 0x42);
+  }
+};
+
+static void BM_EncodeConfigRegisters(benchmark::State &state) {
+  RadioBench bench;
+  nrf905::Config config;
+  nrf905::ConfigBuffer buffer;
+
+  bench.setup();
+  config = bench.rf.getConfig();
+
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    bench.rf.encodeConfigRegisters(&config, &buffer);
+    benchmark::DoNotOptimize(buffer);
+  }
+}
+BENCHMARK(BM_EncodeConfigRegisters);
+
+static void BM_DecodeConfigRegisters(benchmark::State &state) {
+  RadioBench bench;
+  nrf905::Config config;
+  nrf905::ConfigBuffer buffer;
+
+  bench.setup();
+  config = bench.rf.getConfig();
+  bench.rf.encodeConfigRegisters(&config, &buffer);
+
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    bench.rf.decodeConfigRegisters(&buffer, &config);
+    benchmark::DoNotOptimize(config);
+  }
+}
+BENCHMARK(BM_DecodeConfigRegisters);
+
+static void BM_HexArrayToStr(benchmark::State &state) {
+  TestRF rf;
+  uint8_t data[NRF905_MAX_FRAMESIZE];
+
+  for (size_t i = 0; i < sizeof(data); ++i) {
+    data[i] = (uint8_t) (i * 37);
+  }
+
+  {
+    AllocationCounter counter(state);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(rf.hexArrayToStr(data, state.range(0)));
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HexArrayToStr)->Arg(FAN_FRAMESIZE)->Arg(NRF905_MAX_FRAMESIZE);
+
+static void BM_RfFrameEncode(benchmark::State &state) {
+  uint8_t frame[FAN_FRAMESIZE];
+  const zehnder::RfAddress address = {zehnder::FAN_TYPE_MAIN_UNIT, 0x42, zehnder::FAN_TYPE_REMOTE_CONTROL, 0x17};
+  uint8_t speed = 0;
+
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    zehnder::rfFrameEncode(frame, address, zehnder::RfPayloadFanSetTimer{speed, 30});
+    benchmark::DoNotOptimize(frame);
+    speed = (speed + 1) % (zehnder::FAN_SPEED_MAX + 1);
+  }
+}
+BENCHMARK(BM_RfFrameEncode);
+
+// Split and validate only; range(0) is the command
+static void BM_RfFrameDecode(benchmark::State &state) {
+  uint8_t frame[FAN_FRAMESIZE] = {zehnder::FAN_TYPE_REMOTE_CONTROL, 0x17, zehnder::FAN_TYPE_MAIN_UNIT, 0x42, FAN_TTL};
+  zehnder::RfFrame decoded;
+
+  frame[5] = (uint8_t) state.range(0);
+  frame[6] = 3;
+
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(zehnder::rfFrameDecode(frame, sizeof(frame), &decoded));
+    benchmark::DoNotOptimize(decoded);
+  }
+}
+BENCHMARK(BM_RfFrameDecode)
+    ->ArgName("command")
+    ->Arg(zehnder::FAN_TYPE_FAN_SETTINGS)
+    ->Arg(zehnder::FAN_NETWORK_JOIN_OPEN)
+    ->Arg(zehnder::FAN_FRAME_0B);
+
+// Frame building plus the TX payload upload, the radio is not started
+static void BM_QueryDevice(benchmark::State &state) {
+  PairedFan bench;
+
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    bench.fan.force_idle();
+    bench.fan.queryDevice();
+  }
+}
+BENCHMARK(BM_QueryDevice);
+
+static void BM_SetSpeed(benchmark::State &state) {
+  PairedFan bench;
+  uint8_t speed = 0;
+
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    bench.fan.force_idle();
+    bench.fan.setSpeed(speed, (speed & 0x01) ? 10 : 0);
+    speed = (speed + 1) % (zehnder::FAN_SPEED_MAX + 1);
+  }
+}
+BENCHMARK(BM_SetSpeed);
+
+// Frame dispatch for every state and command; range(0) is the state, range(1) the command
+static void BM_RfHandleReceived(benchmark::State &state) {
+  PairedFan bench;
+  uint8_t frame[FAN_FRAMESIZE] = {0};
+  const uint8_t command = (uint8_t) state.range(1);
+
+  // As the main unit would send it to us
+  frame[0] = zehnder::FAN_TYPE_REMOTE_CONTROL;
+  frame[1] = 0x17;
+  frame[2] = zehnder::FAN_TYPE_MAIN_UNIT;
+  frame[3] = 0x42;
+  frame[4] = FAN_TTL;
+  frame[5] = command;
+  frame[6] = zehnder::rfFrameParameterCount(command) != FAN_FRAME_PARAMETERS_ANY
+                 ? zehnder::rfFrameParameterCount(command)
+                 : 3;
+  frame[7] = 0x02;
+  frame[8] = 50;
+  if ((command == zehnder::FAN_NETWORK_JOIN_OPEN) || (command == zehnder::FAN_NETWORK_JOIN_REQUEST)) {
+    frame[7] = (uint8_t) NETWORK_ID;
+    frame[8] = (uint8_t) (NETWORK_ID >> 8);
+    frame[9] = (uint8_t) (NETWORK_ID >> 16);
+    frame[10] = (uint8_t) (NETWORK_ID >> 24);
+  } else if (command == zehnder::FAN_TYPE_QUERY_NETWORK) {
+    frame[0] = zehnder::FAN_TYPE_MAIN_UNIT;
+    frame[1] = 0x42;
+  }
+
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    bench.fan.force_state((uint8_t) state.range(0));
+    bench.fan.rfHandleReceived(frame, sizeof(frame));
+    advance_us((FAN_DEDUP_WINDOW + 1) * 1000);  // Every frame is news, not a repeated copy
+  }
+}
+
+// A repeated copy of the frame just handled
+static void BM_RfHandleReceivedDuplicate(benchmark::State &state) {
+  PairedFan bench;
+  uint8_t frame[FAN_FRAMESIZE] = {0};
+
+  zehnder::rfFrameEncode(frame, {zehnder::FAN_TYPE_REMOTE_CONTROL, 0x33, zehnder::FAN_TYPE_MAIN_UNIT, 0x42},
+                         zehnder::RfPayloadFanSettings{0x02, 50, 0});
+  bench.fan.force_idle();
+  bench.fan.rfHandleReceived(frame, sizeof(frame));
+
+  AllocationCounter counter(state);
+  for (auto _ : state) {
+    bench.fan.rfHandleReceived(frame, sizeof(frame));
+  }
+}
+BENCHMARK(BM_RfHandleReceivedDuplicate);
+
+static void RfHandleReceivedArgs(benchmark::internal::Benchmark *b) {
+  static const uint8_t commands[] = {
+      zehnder::FAN_FRAME_SETVOLTAGE,     zehnder::FAN_FRAME_SETSPEED,       zehnder::FAN_FRAME_SETTIMER,
+      zehnder::FAN_NETWORK_JOIN_REQUEST, zehnder::FAN_FRAME_SETSPEED_REPLY, zehnder::FAN_NETWORK_JOIN_OPEN,
+      zehnder::FAN_TYPE_FAN_SETTINGS,    zehnder::FAN_FRAME_0B,             zehnder::FAN_NETWORK_JOIN_ACK,
+      zehnder::FAN_TYPE_QUERY_NETWORK,   zehnder::FAN_TYPE_QUERY_DEVICE,    zehnder::FAN_FRAME_SETVOLTAGE_REPLY,
+  };
+
+  b->ArgNames({"state", "command"});
+  for (uint8_t state = 0; state < TestZehnderRF::STATE_COUNT; ++state) {
+    for (uint8_t command : commands) {
+      b->Args({state, command});
+    }
+  }
+}
+BENCHMARK(BM_RfHandleReceived)->Apply(RfHandleReceivedArgs);
+
+BENCHMARK_MAIN();
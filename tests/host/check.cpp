@@ -0,0 +1,29 @@
+#include "check.h"
+
+namespace esphome {
+namespace host {
+
+int check_failures = 0;
+
+int run_tests(const TestCase *cases, size_t count) {
+  int failed = 0;
+
+  for (size_t i = 0; i < count; ++i) {
+    int before = check_failures;
+
+    cases[i].run();
+    if (check_failures != before) {
+      ++failed;
+      std::printf("  ✗ %s\n", cases[i].name);
+    } else {
+      std::printf("  ✓ %s\n", cases[i].name);
+    }
+  }
+
+  std::printf("%zu tests, %d failed\n", count, failed);
+
+  return failed == 0 ? 0 : 1;
+}
+
+}  // namespace host
+}  // namespace esphome
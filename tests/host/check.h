@@ -0,0 +1,38 @@
+// Minimal check macros for the host test programs
+#pragma once
+
+#include <cstdio>
+
+namespace esphome {
+namespace host {
+
+extern int check_failures;
+
+typedef struct {
+  const char *name;
+  void (*run)(void);
+} TestCase;
+
+// Runs the cases in order, returns the process exit code
+int run_tests(const TestCase *cases, size_t count);
+
+}  // namespace host
+}  // namespace esphome
+
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      std::printf("    FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+      ++::esphome::host::check_failures; \
+    } \
+  } while (0)
+
+#define CHECK_EQ(a, b) \
+  do { \
+    long long check_a_ = (long long) (a); \
+    long long check_b_ = (long long) (b); \
+    if (check_a_ != check_b_) { \
+      std::printf("    FAIL %s:%d: %s == %s (%lld != %lld)\n", __FILE__, __LINE__, #a, #b, check_a_, check_b_); \
+      ++::esphome::host::check_failures; \
+    } \
+  } while (0)
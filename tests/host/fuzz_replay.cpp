@@ -0,0 +1,152 @@
+// Runs a fuzz target without libFuzzer: replays corpus files, then optionally random mutations of them
+//
+//   fuzz_replay [--random N] [--seed N] <file or directory>...
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <random>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static bool read_file(const std::string &path, std::vector<uint8_t> *contents) {
+  FILE *f = std::fopen(path.c_str(), "rb");
+  uint8_t buffer[256];
+  size_t n;
+
+  if (f == NULL) {
+    return false;
+  }
+  contents->clear();
+  while ((n = std::fread(buffer, 1, sizeof(buffer), f)) > 0) {
+    contents->insert(contents->end(), buffer, buffer + n);
+  }
+  std::fclose(f);
+
+  return true;
+}
+
+static void collect(const std::string &path, std::vector<std::string> *files) {
+  struct stat st;
+  DIR *dir;
+  struct dirent *entry;
+  std::vector<std::string> names;
+
+  if (stat(path.c_str(), &st) != 0) {
+    std::printf("Cannot open %s\n", path.c_str());
+    std::exit(2);
+  }
+  if (!S_ISDIR(st.st_mode)) {
+    files->push_back(path);
+    return;
+  }
+
+  dir = opendir(path.c_str());
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] != '.') {
+      names.push_back(path + "/" + entry->d_name);
+    }
+  }
+  closedir(dir);
+
+  // Same order on every machine
+  std::sort(names.begin(), names.end());
+  files->insert(files->end(), names.begin(), names.end());
+}
+
+// Small mutations in the spirit of libFuzzer's: flip bits, set bytes, insert, erase, splice
+static void mutate(std::vector<uint8_t> *input, const std::vector<std::vector<uint8_t>> &corpus, std::mt19937 &rng) {
+  const uint32_t count = 1 + rng() % 4;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const size_t at = input->empty() ? 0 : rng() % input->size();
+
+    switch (rng() % 5) {
+      case 0:
+        if (!input->empty()) {
+          (*input)[at] ^= 1 << (rng() % 8);
+        }
+        break;
+      case 1:
+        if (!input->empty()) {
+          (*input)[at] = (uint8_t) rng();
+        }
+        break;
+      case 2:
+        if (input->size() < 2 + 8 * 32) {
+          input->insert(input->begin() + at, (uint8_t) rng());
+        }
+        break;
+      case 3:
+        if (input->size() > 3) {
+          input->erase(input->begin() + at);
+        }
+        break;
+      default: {
+        const std::vector<uint8_t> &other = corpus[rng() % corpus.size()];
+
+        if (!other.empty()) {
+          size_t from = rng() % other.size();
+          size_t length = 1 + rng() % (other.size() - from);
+
+          for (size_t j = 0; (j < length) && (at + j < input->size()); ++j) {
+            (*input)[at + j] = other[from + j];
+          }
+        }
+        break;
+      }
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> files;
+  std::vector<std::vector<uint8_t>> corpus;
+  uint32_t randomRuns = 0;
+  uint32_t seed = 1;
+
+  for (int i = 1; i < argc; ++i) {
+    if ((std::strcmp(argv[i], "--random") == 0) && (i + 1 < argc)) {
+      randomRuns = std::strtoul(argv[++i], NULL, 0);
+    } else if ((std::strcmp(argv[i], "--seed") == 0) && (i + 1 < argc)) {
+      seed = std::strtoul(argv[++i], NULL, 0);
+    } else {
+      collect(argv[i], &files);
+    }
+  }
+  if (files.empty()) {
+    std::printf("usage: fuzz_replay [--random N] [--seed N] <file or directory>...\n");
+    return 2;
+  }
+
+  for (const std::string &file : files) {
+    std::vector<uint8_t> input;
+
+    if (!read_file(file, &input)) {
+      std::printf("Cannot read %s\n", file.c_str());
+      return 2;
+    }
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+    corpus.push_back(input);
+  }
+  std::printf("Replayed %zu corpus inputs\n", corpus.size());
+
+  if (randomRuns > 0) {
+    std::mt19937 rng(seed);
+
+    for (uint32_t i = 0; i < randomRuns; ++i) {
+      std::vector<uint8_t> input = corpus[rng() % corpus.size()];
+
+      mutate(&input, corpus, rng);
+      LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    std::printf("Ran %u mutated inputs (seed %u)\n", randomRuns, seed);
+  }
+
+  return 0;
+}
@@ -0,0 +1,148 @@
+// Fuzz target for ZehnderRF::rfHandleReceived()
+//
+// Input layout:
+//   byte 0      state the component is put in (modulo the number of states)
+//   byte 1      bit 0: frames are 32 bytes instead of 16
+//   bytes 2..   frames, fed one after another with a millisecond of main loop in between (last one zero padded)
+//
+// After the frames the component runs on until every pending transmission has finished or given up. Invariants:
+//   - rfState_ never stays unchanged longer than the timeout that belongs to it
+//   - speed stays within the speed count, voltage within 0..100
+//   - preferences are only written by the pairing confirmation, and never with an invalid configuration
+//
+// Build with clang -fsanitize=fuzzer for coverage guided fuzzing, or link fuzz_replay.cpp to run a corpus with g++.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+static const uint32_t NETWORK_ID = 0xA1B2C3D4;
+static const uint8_t MAX_FRAMES = 8;
+static const uint32_t FUZZ_TICK_US = 1000;
+static const uint32_t SETTLE_TIME = 20000;  // ms, longer than the longest retry sequence
+
+// Longest time rfState_ may keep one value (with the same retry count), in ms
+static const uint32_t RF_STATE_LIMIT[] = {
+    0xFFFFFFFF,                // RfStateIdle
+    5000 + 100,                // RfStateWaitAirwayFree
+    2000 + 100,                // RfStateTxBusy, MAX_TRANSMIT_TIME
+    FAN_REPLY_TIMEOUT + 100,   // RfStateRxWait
+};
+
+static const uint8_t *fuzz_data;
+static size_t fuzz_size;
+
+static void fail(const char *what) {
+  std::printf("Invariant violated: %s\nInput:", what);
+  for (size_t i = 0; i < fuzz_size; ++i) {
+    std::printf(" %02X", fuzz_data[i]);
+  }
+  std::printf("\n");
+  std::fflush(stdout);
+  std::abort();
+}
+
+typedef struct {
+  uint8_t rfState;
+  int8_t retries;
+  uint32_t since;
+} RfProgress;
+
+static void check(FanBench &bench, RfProgress *progress) {
+  TestZehnderRF &fan = bench.fan;
+  uint8_t rfState = fan.rf_state();
+
+  if ((fan.speed < 0) || (fan.speed > fan.speed_count())) {
+    fail("speed out of range");
+  }
+  if ((fan.voltage < 0) || (fan.voltage > 100)) {
+    fail("voltage out of range");
+  }
+
+  if ((rfState != progress->rfState) || (fan.retries() != progress->retries)) {
+    progress->rfState = rfState;
+    progress->retries = fan.retries();
+    progress->since = millis();
+  } else if ((rfState < sizeof(RF_STATE_LIMIT) / sizeof(RF_STATE_LIMIT[0])) &&
+             ((millis() - progress->since) > RF_STATE_LIMIT[rfState])) {
+    fail("rfState_ stuck");
+  }
+}
+
+static void step(FanBench &bench, RfProgress *progress) {
+  advance_us(FUZZ_TICK_US);
+  bench.sim.step();
+  bench.rf.loop();
+  bench.fan.loop();
+  check(bench, progress);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+  FanBench bench;
+  RfProgress progress = {0, -1, 0};
+  uint8_t frame[NRF905_MAX_FRAMESIZE];
+  uint8_t frameSize;
+  uint32_t saves;
+  size_t offset = 2;
+  uint8_t state;
+
+  if (size < 3) {
+    return 0;
+  }
+  fuzz_data = data;
+  fuzz_size = size;
+
+  state = data[0] % TestZehnderRF::STATE_COUNT;
+  frameSize = (data[1] & 0x01) ? NRF905_MAX_FRAMESIZE : FAN_FRAMESIZE;
+
+  // Paired, past startup and not polling by itself
+  set_time_us(20000000ULL);
+  seed_random(1);
+  bench.fan.set_update_interval(0xFFFFFFFF);
+  bench.fan.set_passive_tracking(true);  // Reach the overheard settings path as well
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, 0x17, zehnder::FAN_TYPE_MAIN_UNIT, 0x42);
+  bench.fan.force_state(state);
+  saves = global_preferences->save_count;
+
+  for (uint8_t i = 0; (i < MAX_FRAMES) && (offset < size); ++i) {
+    const bool pairing = bench.fan.phase() == TestZehnderRF::PhasePairing;
+    size_t length = size - offset;
+
+    if (length > frameSize) {
+      length = frameSize;
+    }
+    std::memset(frame, 0, sizeof(frame));
+    std::memcpy(frame, data + offset, length);
+    offset += length;
+
+    bench.fan.rfHandleReceived(frame, frameSize);
+    check(bench, &progress);
+
+    if (global_preferences->save_count != saves) {
+      // Only the network join confirmation stores the pairing
+      if (!pairing || (frame[5] != zehnder::FAN_TYPE_QUERY_NETWORK)) {
+        fail("unexpected preference write");
+      }
+      if ((bench.fan.network_id() == 0) || (bench.fan.device_id() == 0)) {
+        fail("invalid pairing stored");
+      }
+      saves = global_preferences->save_count;
+    }
+
+    for (uint8_t t = 0; t < 10; ++t) {
+      step(bench, &progress);
+    }
+  }
+
+  // Everything that was started has to finish or give up
+  for (uint32_t t = 0; t < SETTLE_TIME * 1000 / FUZZ_TICK_US; ++t) {
+    step(bench, &progress);
+  }
+
+  return 0;
+}
@@ -0,0 +1,223 @@
+// Host harness: wires the nRF905 driver (and optionally ZehnderRF) to the simulated chip and clock
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+
+#include "esphome/core/hal.h"
+#include "esphome/core/preferences.h"
+#include "esphome/components/nrf905/nRF905.h"
+#include "esphome/components/zehnder/zehnder.h"
+
+#include "nrf905_sim.h"
+
+namespace esphome {
+namespace host {
+
+// Driver with the protected parts the tests look at made reachable
+class TestRF : public nrf905::nRF905 {
+ public:
+  using nrf905::nRF905::decodeConfigRegisters;
+  using nrf905::nRF905::encodeConfigRegisters;
+  using nrf905::nRF905::hexArrayToStr;
+
+  uint32_t data_rate() const { return this->data_rate_; }
+};
+
+class TestZehnderRF : public zehnder::ZehnderRF {
+ public:
+  using zehnder::ZehnderRF::control;
+  using zehnder::ZehnderRF::rfHandleReceived;
+  using zehnder::ZehnderRF::queryDevice;
+  using zehnder::ZehnderRF::rfTaskStep;
+
+  // What the component is busy with, coarser than its state machine
+  typedef enum { PhaseStartup, PhasePairing, PhaseIdle, PhaseQuery, PhaseSetSpeed, PhaseOther } Phase;
+
+  Phase phase() const {
+    switch (this->state_) {
+      case StateStartup:
+        return PhaseStartup;
+      case StateStartDiscovery:
+      case StateDiscoveryWaitForLinkRequest:
+      case StateDiscoveryWaitForJoinResponse:
+      case StateDiscoveryJoinComplete:
+        return PhasePairing;
+      case StateIdle:
+        return PhaseIdle;
+      case StateWaitQueryResponse:
+        return PhaseQuery;
+      case StateWaitSetSpeedResponse:
+        return PhaseSetSpeed;
+      default:
+        return PhaseOther;
+    }
+  }
+
+  uint32_t network_id() const { return this->config_.fan_networkId; }
+  uint8_t device_id() const { return this->config_.fan_my_device_id; }
+
+  // Put the state machines in a given state, for driving rfHandleReceived() directly
+  static const uint8_t STATE_COUNT = StateNrOf;
+  void force_state(uint8_t state) {
+    this->state_ = (State) state;
+    this->rfState_ = RfStateIdle;
+    this->retries_ = -1;
+    this->rfBusy_ = false;
+    this->onReceiveTimeout_ = NULL;
+    this->rfCommands_.clear();
+    this->rfEvents_.clear();
+  }
+  void force_idle() { this->force_state(StateIdle); }
+
+  uint8_t rf_state() const { return this->rfState_; }
+  int8_t retries() const { return this->retries_; }
+  int speed_count() const { return this->speed_count_; }
+  uint8_t commands_pending() const { return this->commandCount_; }
+  uint32_t commands_dropped() const { return this->commandsDropped_; }
+  uint32_t poll_delay() const { return this->pollDelay_; }
+  uint32_t consecutive_timeouts() const { return this->consecutive_timeouts_; }
+
+  // Latency histograms of speed commands and polls, per stage
+  static const uint8_t LATENCY_WAIT = LatencyWait;
+  static const uint8_t LATENCY_TRANSMIT = LatencyTransmit;
+  static const uint8_t LATENCY_REPLY = LatencyReply;
+  static const uint8_t LATENCY_CONFIRM = LatencyConfirm;
+  static const uint8_t LATENCY_TOTAL = LatencyTotal;
+  const zehnder::LatencyHistogram &command_latency(uint8_t stage) const {
+    return this->latency_[CommandSetSpeed][stage];
+  }
+  const zehnder::LatencyHistogram &query_latency(uint8_t stage) const { return this->latency_[CommandQuery][stage]; }
+  // Settings frames applied, published or not (no rate limit or heartbeat configured)
+  uint32_t settings_received() const { return this->publishesEmitted_ + this->publishesSuppressed_; }
+};
+
+// Simulation step; the main loop runs every step unless a loop period is set
+static const uint32_t LOOP_TICK_US = 100;
+// Loop period of a real ESPHome main loop
+static const uint32_t ESPHOME_LOOP_US = 16000;
+
+class RadioBench {
+ public:
+  explicit RadioBench(bool interrupts = true) {
+    set_time_us(0);
+    seed_random(1);
+    global_preferences->store.clear();
+    global_preferences->save_count = 0;
+    spi_bus = &this->sim;
+
+    this->rf.set_cs_pin(&this->sim.pin_cs);
+    this->rf.set_ce_pin(&this->sim.pin_ce);
+    this->rf.set_pwr_pin(&this->sim.pin_pwr);
+    this->rf.set_txen_pin(&this->sim.pin_txen);
+    this->rf.set_cd_pin(&this->sim.pin_cd);
+    if (interrupts) {
+      this->rf.set_dr_pin(&this->sim.pin_dr);
+      this->rf.set_am_pin(&this->sim.pin_am);
+    }
+  }
+
+  void setup() { this->rf.setup(); }
+
+  // Run the main loop only every period, the chip and its interrupts still every step; 0 runs it every step
+  void set_loop_period(uint32_t us) { this->loop_period_us_ = us; }
+
+  // One simulation step after moving the clock, plus a pass of the main loop when due
+  virtual void tick() {
+    advance_us(LOOP_TICK_US);
+    this->step_world();
+    this->sim.step();
+    if (this->loop_due()) {
+      this->main_loop();
+    }
+  }
+
+  void run_us(uint64_t us) {
+    uint64_t end = time_us() + us;
+
+    while (time_us() < end) {
+      this->tick();
+    }
+  }
+
+  virtual ~RadioBench() {
+    if (spi_bus == &this->sim) {
+      spi_bus = nullptr;
+    }
+  }
+
+  nRF905Sim sim;
+  TestRF rf;
+  // Called every step once the clock moved, before the chip runs; drives whatever else is on the air
+  std::function<void()> on_step;
+
+ protected:
+  void step_world() {
+    if (this->on_step) {
+      this->on_step();
+    }
+  }
+
+  bool loop_due() {
+    if (this->loop_period_us_ != 0) {
+      if ((time_us() - this->loop_at_) < this->loop_period_us_) {
+        return false;
+      }
+      this->loop_at_ = time_us();
+    }
+    return true;
+  }
+
+  virtual void main_loop() { this->rf.loop(); }
+
+  uint32_t loop_period_us_{0};
+  uint64_t loop_at_{0};
+};
+
+class FanBench : public RadioBench {
+ public:
+  explicit FanBench(bool interrupts = true) : RadioBench(interrupts) {
+    this->fan.set_rf(&this->rf);
+    this->fan.set_update_interval(15000);
+  }
+
+  void setup() {
+    this->rf.setup();
+    this->fan.setup();
+  }
+
+  // Run the radio and the RF engine as the RF task would, every tick, and the main loop only every period
+  void enable_rf_task(uint32_t main_loop_period_us) {
+    this->fan.set_rf_task(true);
+    this->rf.setServicedExternally(true);
+    this->rf_task_ = true;
+    this->set_loop_period(main_loop_period_us);
+  }
+
+  void tick() override {
+    advance_us(LOOP_TICK_US);
+    this->step_world();
+    this->sim.step();
+    if (this->rf_task_) {
+      this->rf.service();
+      this->fan.rfTaskStep();
+    }
+    if (this->loop_due()) {
+      this->main_loop();
+    }
+  }
+
+  TestZehnderRF fan;
+
+ protected:
+  void main_loop() override {
+    this->rf.loop();
+    this->fan.loop();
+  }
+
+  bool rf_task_{false};
+};
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,123 @@
+// Runs ZehnderRF on a simulated 868 MHz channel and reports command latency, retries and airtime
+//
+//   netsim [--seed N] [--runs N] [--duration S] [--loss P] [--delay-min MS] [--delay-max MS] [--copies N]
+//          [--co2 N] [--remotes N] [--competitor-interval MS] [--no-lbt] [--poll MS] [--poll-min MS]
+//          [--poll-max MS] [--no-passive] [--set-speed MS] [--unpaired] [--loop-period MS]
+//
+// With --runs, the scenario is repeated with consecutive seeds and one report covers all runs. The main loop runs
+// every 16 ms as on a real ESPHome node; --loop-period 0 runs it on every 100 us step instead, for comparison.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "rf_network.h"
+
+using namespace esphome::host;
+
+static void usage() {
+  std::printf("usage: netsim [--seed N] [--runs N] [--duration S] [--loss P] [--delay-min MS] [--delay-max MS]\n"
+              "              [--copies N] [--co2 N] [--remotes N] [--competitor-interval MS] [--no-lbt]\n"
+              "              [--poll MS] [--poll-min MS] [--poll-max MS] [--no-passive] [--set-speed MS]\n"
+              "              [--unpaired] [--loop-period MS]\n");
+}
+
+static void merge(CommandStats *total, const CommandStats &run) {
+  total->count += run.count;
+  total->ok += run.ok;
+  total->failed += run.failed;
+  total->bursts += run.bursts;
+  total->latency.insert(total->latency.end(), run.latency.begin(), run.latency.end());
+}
+
+int main(int argc, char **argv) {
+  NetworkScenario scenario = default_scenario();
+  NetworkStats total;
+  uint32_t runs = 1;
+
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+    if (std::strcmp(arg, "--no-lbt") == 0) {
+      scenario.competitor_lbt = false;
+    } else if (std::strcmp(arg, "--no-passive") == 0) {
+      scenario.passive_tracking = false;
+    } else if (std::strcmp(arg, "--unpaired") == 0) {
+      scenario.paired = false;
+    } else if (value == NULL) {
+      usage();
+      return 2;
+    } else {
+      ++i;
+      if (std::strcmp(arg, "--seed") == 0) {
+        scenario.seed = std::strtoul(value, NULL, 0);
+      } else if (std::strcmp(arg, "--runs") == 0) {
+        runs = std::strtoul(value, NULL, 0);
+      } else if (std::strcmp(arg, "--duration") == 0) {
+        scenario.duration = std::strtoul(value, NULL, 0) * 1000;
+      } else if (std::strcmp(arg, "--loss") == 0) {
+        scenario.loss = std::strtod(value, NULL);
+      } else if (std::strcmp(arg, "--delay-min") == 0) {
+        scenario.reply_delay_min = std::strtod(value, NULL) * 1000;
+      } else if (std::strcmp(arg, "--delay-max") == 0) {
+        scenario.reply_delay_max = std::strtod(value, NULL) * 1000;
+      } else if (std::strcmp(arg, "--copies") == 0) {
+        scenario.main_unit_copies = std::strtoul(value, NULL, 0);
+      } else if (std::strcmp(arg, "--co2") == 0) {
+        scenario.co2_sensors = std::strtoul(value, NULL, 0);
+      } else if (std::strcmp(arg, "--remotes") == 0) {
+        scenario.remotes = std::strtoul(value, NULL, 0);
+      } else if (std::strcmp(arg, "--competitor-interval") == 0) {
+        scenario.competitor_interval = std::strtoul(value, NULL, 0);
+      } else if (std::strcmp(arg, "--poll") == 0) {
+        scenario.poll_interval = std::strtoul(value, NULL, 0);
+      } else if (std::strcmp(arg, "--poll-min") == 0) {
+        scenario.poll_interval_min = std::strtoul(value, NULL, 0);
+      } else if (std::strcmp(arg, "--poll-max") == 0) {
+        scenario.poll_interval_max = std::strtoul(value, NULL, 0);
+      } else if (std::strcmp(arg, "--set-speed") == 0) {
+        scenario.set_speed_interval = std::strtoul(value, NULL, 0);
+      } else if (std::strcmp(arg, "--loop-period") == 0) {
+        scenario.loop_period = std::strtod(value, NULL) * 1000;
+      } else {
+        usage();
+        return 2;
+      }
+    }
+  }
+  if (scenario.reply_delay_max < scenario.reply_delay_min) {
+    scenario.reply_delay_max = scenario.reply_delay_min;
+  }
+
+  for (uint32_t run = 0; run < runs; ++run) {
+    NetworkScenario current = scenario;
+    NetworkStats stats;
+
+    current.seed = scenario.seed + run;
+    RfNetwork network(current);
+    stats = network.run();
+
+    if (run == 0) {
+      total = stats;
+      continue;
+    }
+    merge(&total.query, stats.query);
+    merge(&total.set_speed, stats.set_speed);
+    merge(&total.pairing, stats.pairing);
+    for (size_t n = 0; n < total.nodes.size(); ++n) {
+      total.nodes[n].copies += stats.nodes[n].copies;
+      total.nodes[n].airtime += stats.nodes[n].airtime;
+    }
+    total.collisions += stats.collisions;
+    total.losses += stats.losses;
+    total.deferrals += stats.deferrals;
+    total.duration += stats.duration;
+  }
+
+  if (runs > 1) {
+    std::printf("%u runs\n", runs);
+  }
+  print_report(scenario, total);
+
+  return 0;
+}
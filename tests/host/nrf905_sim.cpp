@@ -0,0 +1,318 @@
+#include "nrf905_sim.h"
+
+#include <cstring>
+
+#include "esphome/core/hal.h"
+
+namespace esphome {
+namespace host {
+
+// Instructions, see nRF905 datasheet section 9.3
+static const uint8_t W_CONFIG = 0x00;
+static const uint8_t R_CONFIG = 0x10;
+static const uint8_t W_TX_PAYLOAD = 0x20;
+static const uint8_t R_TX_PAYLOAD = 0x21;
+static const uint8_t W_TX_ADDRESS = 0x22;
+static const uint8_t R_TX_ADDRESS = 0x23;
+static const uint8_t R_RX_PAYLOAD = 0x24;
+static const uint8_t CHANNEL_CONFIG = 0x80;
+static const uint8_t NOP = 0xFF;
+
+static const uint32_t POWERUP_TIME = 3000;
+static const uint32_t SETTLE_TIME = 650;
+
+void SimPin::set_level(bool value) {
+  if (value == this->level_) {
+    return;
+  }
+  this->level_ = value;
+
+  if (this->on_change) {
+    this->on_change(value);
+  }
+
+  if (this->isr_ != nullptr) {
+    if ((this->isr_type_ == gpio::INTERRUPT_ANY_EDGE) || (value && (this->isr_type_ == gpio::INTERRUPT_RISING_EDGE)) ||
+        (!value && (this->isr_type_ == gpio::INTERRUPT_FALLING_EDGE))) {
+      this->isr_(this->isr_arg_);
+    }
+  }
+}
+
+void SimPin::attach_interrupt(void (*func)(void *), void *arg, gpio::InterruptType type) const {
+  this->isr_ = func;
+  this->isr_arg_ = arg;
+  this->isr_type_ = type;
+}
+
+nRF905Sim::nRF905Sim() {
+  // Power on reset values
+  static const uint8_t reset[10] = {0x6C, 0x00, 0x44, 0x20, 0x20, 0xE7, 0xE7, 0xE7, 0xE7, 0xE7};
+
+  std::memcpy(this->regs, reset, sizeof(this->regs));
+  std::memset(this->tx_payload, 0, sizeof(this->tx_payload));
+  std::memset(this->tx_addr, 0xE7, sizeof(this->tx_addr));
+  std::memset(this->rx_payload, 0, sizeof(this->rx_payload));
+  std::memset(&this->stats, 0, sizeof(this->stats));
+
+  this->pin_cs.set_level(true);
+  this->pin_cs.on_change = [this](bool level) { this->on_cs(level); };
+  this->pin_pwr.on_change = [this](bool level) {
+    if (level) {
+      this->power_up_at_ = time_us() + POWERUP_TIME;
+    } else {
+      this->pin_dr.set_level(false);
+      this->pin_am.set_level(false);
+      // Only the configuration register is guaranteed to survive power down
+      std::memset(this->tx_payload, 0xA5, sizeof(this->tx_payload));
+    }
+    this->on_mode_pin();
+  };
+  this->pin_ce.on_change = [this](bool) { this->on_mode_pin(); };
+  this->pin_txen.on_change = [this](bool) { this->on_mode_pin(); };
+}
+
+void nRF905Sim::acquire(uint32_t data_rate) {
+  ++this->stats.acquisitions;
+  this->data_rate_ = data_rate;
+}
+
+void nRF905Sim::release() {}
+
+void nRF905Sim::transfer(uint8_t *data, size_t length) {
+  if (!this->selected_) {
+    return;  // CSN high, the chip does not listen
+  }
+
+  for (size_t i = 0; i < length; ++i) {
+    if (this->tracing) {
+      this->current_.push_back(data[i]);
+    }
+    data[i] = this->clock_byte(data[i]);
+    ++this->position_;
+    ++this->stats.bytes;
+  }
+}
+
+uint8_t nRF905Sim::clock_byte(uint8_t mosi) {
+  uint8_t miso = 0;
+  size_t idx;
+
+  if (this->position_ == 0) {
+    this->command_ = mosi;
+    if (mosi <= (W_CONFIG | 0x0F)) {
+      ++this->stats.config_writes;
+    } else if ((mosi & 0xF0) == R_CONFIG) {
+      ++this->stats.config_reads;
+    } else if (mosi == W_TX_PAYLOAD) {
+      ++this->stats.payload_writes;
+    } else if (mosi == R_RX_PAYLOAD) {
+      ++this->stats.rx_payload_reads;
+    } else if ((mosi & 0xF0) == CHANNEL_CONFIG) {
+      ++this->stats.channel_configs;
+    } else if (mosi == NOP) {
+      ++this->stats.status_reads;
+    }
+    miso = this->status();
+  } else {
+    idx = this->position_ - 1;
+
+    if (this->command_ <= (W_CONFIG | 0x0F)) {
+      idx += this->command_ & 0x0F;
+      if (idx < sizeof(this->regs)) {
+        this->regs[idx] = mosi;
+      }
+    } else if ((this->command_ & 0xF0) == R_CONFIG) {
+      idx += this->command_ & 0x0F;
+      if (idx < sizeof(this->regs)) {
+        miso = this->regs[idx];
+      }
+    } else if (this->command_ == W_TX_PAYLOAD) {
+      if (idx < sizeof(this->tx_payload)) {
+        this->tx_payload[idx] = mosi;
+      }
+    } else if (this->command_ == R_TX_PAYLOAD) {
+      if (idx < sizeof(this->tx_payload)) {
+        miso = this->tx_payload[idx];
+      }
+    } else if (this->command_ == W_TX_ADDRESS) {
+      if (idx < sizeof(this->tx_addr)) {
+        this->tx_addr[idx] = mosi;
+      }
+    } else if (this->command_ == R_TX_ADDRESS) {
+      if (idx < sizeof(this->tx_addr)) {
+        miso = this->tx_addr[idx];
+      }
+    } else if (this->command_ == R_RX_PAYLOAD) {
+      if (idx < sizeof(this->rx_payload)) {
+        miso = this->rx_payload[idx];
+      }
+    } else if ((this->command_ & 0xF0) == CHANNEL_CONFIG) {
+      if (idx == 0) {
+        this->regs[0] = mosi;
+        this->regs[1] = (this->regs[1] & 0xF0) | (this->command_ & 0x0F);
+      }
+    }
+  }
+
+  // Clocked too fast for the wiring, reads come back garbled
+  if (this->data_rate_ > this->max_data_rate_) {
+    miso ^= 0x5A;
+  }
+
+  return miso;
+}
+
+void nRF905Sim::on_cs(bool level) {
+  if (!level) {
+    this->selected_ = true;
+    this->position_ = 0;
+    this->current_.clear();
+    ++this->stats.instructions;
+    return;
+  }
+
+  this->selected_ = false;
+  if ((this->command_ == R_RX_PAYLOAD) && (this->position_ > 1)) {
+    // Reading the payload clears DR and AM
+    this->pin_dr.set_level(false);
+    this->pin_am.set_level(false);
+  }
+  if (this->tracing) {
+    this->trace.push_back(this->current_);
+  }
+}
+
+void nRF905Sim::on_mode_pin() {
+  bool rx = this->pin_pwr.level() && this->pin_ce.level() && !this->pin_txen.level();
+
+  if (rx && !this->rx_) {
+    this->rx_since_ = time_us() > this->power_up_at_ ? time_us() : this->power_up_at_;
+  }
+  this->rx_ = rx;
+
+  if (this->pin_pwr.level() && this->pin_ce.level() && this->pin_txen.level()) {
+    if (this->tx_end_at_ == 0) {
+      uint64_t start = time_us();
+
+      if (start < this->power_up_at_) {
+        start = this->power_up_at_;
+      }
+      this->tx_end_at_ = start + SETTLE_TIME + this->airtime_us();
+    }
+  } else if ((this->tx_end_at_ != 0) && this->pin_pwr.level() && this->pin_txen.level()) {
+    // CE dropped during TX: the packet on air is finished, then the chip goes to standby (step() stops there)
+  } else if (this->tx_end_at_ != 0) {
+    // Transmission aborted or done, DR of a transmission only lasts while in TX
+    if (time_us() + this->airtime_us() > this->tx_end_at_) {
+      ++this->stats.copies_aborted;  // Cut off while on air
+    }
+    this->tx_end_at_ = 0;
+    this->pin_dr.set_level(false);
+  } else if (this->pin_dr.level() && !this->pin_am.level()) {
+    this->pin_dr.set_level(false);
+  }
+}
+
+void nRF905Sim::step() {
+  uint64_t now = time_us();
+
+  while ((this->tx_end_at_ != 0) && (now >= this->tx_end_at_)) {
+    SimPacket packet;
+    uint8_t width = this->regs[4] & 0x3F;
+
+    packet.time = this->tx_end_at_;
+    packet.address = this->tx_address();
+    packet.channel = this->channel();
+    packet.band = this->band();
+    packet.payload.assign(this->tx_payload, this->tx_payload + (width > 32 ? 32 : width));
+    ++this->stats.copies_sent;
+
+    if ((this->regs[1] & 0x20) && this->pin_ce.level()) {
+      // Auto retransmit: DR pulses at the end of each copy and the next one starts right away, for as long as CE
+      // stays high
+      this->tx_end_at_ += this->airtime_us();
+      this->pin_dr.set_level(true);
+      this->pin_dr.set_level(false);
+    } else {
+      // Stays in TX mode (or standby, with CE low), but does not send again until TX is re-entered
+      this->tx_end_at_ = 0;
+      this->pin_dr.set_level(true);
+    }
+
+    if (this->on_transmit) {
+      this->on_transmit(packet);
+    }
+  }
+}
+
+void nRF905Sim::receive(const SimPacket &packet) {
+  uint8_t width = this->regs[3] & 0x3F;
+  uint8_t addressWidth = this->regs[2] & 0x07;
+  uint32_t mask = (addressWidth >= 4) ? 0xFFFFFFFF : ((1UL << (addressWidth * 8)) - 1);
+
+  if (!this->listening() || (packet.channel != this->channel()) || (packet.band != this->band())) {
+    return;
+  }
+  if ((packet.address & mask) != (this->rx_address() & mask)) {
+    return;
+  }
+  if (this->pin_dr.level()) {
+    ++this->stats.rx_overrun;
+    return;
+  }
+
+  std::memset(this->rx_payload, 0, sizeof(this->rx_payload));
+  std::memcpy(this->rx_payload, packet.payload.data(),
+              packet.payload.size() < width ? packet.payload.size() : (width > 32 ? 32 : width));
+  ++this->stats.rx_delivered;
+
+  this->pin_am.set_level(true);
+  this->pin_dr.set_level(true);
+}
+
+void nRF905Sim::set_carrier(bool busy) { this->pin_cd.set_level(busy); }
+
+uint32_t nRF905Sim::airtime_us() const {
+  uint32_t bits = 10 + ((((this->regs[2] >> 4) & 0x07) + (this->regs[4] & 0x3F)) * 8);
+
+  if (this->regs[9] & 0x40) {
+    bits += (this->regs[9] & 0x80) ? 16 : 8;
+  }
+
+  return bits * 20;
+}
+
+uint32_t nRF905Sim::rx_address() const {
+  return this->regs[5] | (this->regs[6] << 8) | (this->regs[7] << 16) | ((uint32_t) this->regs[8] << 24);
+}
+
+uint32_t nRF905Sim::tx_address() const {
+  return this->tx_addr[0] | (this->tx_addr[1] << 8) | (this->tx_addr[2] << 16) | ((uint32_t) this->tx_addr[3] << 24);
+}
+
+bool nRF905Sim::ready() const { return this->pin_pwr.level() && (time_us() >= this->power_up_at_); }
+
+bool nRF905Sim::listening() const {
+  return this->rx_ && this->ready() && (time_us() >= this->rx_since_ + SETTLE_TIME);
+}
+
+bool nRF905Sim::transmitting() const { return this->tx_end_at_ != 0; }
+
+uint64_t nRF905Sim::air_start() const {
+  uint64_t start;
+
+  if (this->tx_end_at_ == 0) {
+    return 0;
+  }
+  start = this->tx_end_at_ - this->airtime_us();
+
+  return (time_us() >= start) ? start : 0;
+}
+
+uint8_t nRF905Sim::status() const {
+  return (this->pin_dr.level() ? (1 << 5) : 0) | (this->pin_am.level() ? (1 << 7) : 0);
+}
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,140 @@
+// Register level nRF905 simulator for host builds
+//
+// Plugs in below nRF905::spiTransfer() through the host SPI bus and provides the GPIOPins the driver is given.
+// It models the config register file, TX/RX payload and TX address buffers, the status byte (DR/AM), the CD line
+// and the power up / settling / airtime timing of the chip, driven by the simulated host clock.
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "esphome/core/gpio.h"
+#include "esphome/components/spi/spi.h"
+
+namespace esphome {
+namespace host {
+
+class SimPin : public InternalGPIOPin {
+ public:
+  explicit SimPin(const char *name) : name_(name) {}
+
+  bool digital_read() override { return this->level_; }
+  void digital_write(bool value) override { this->set_level(value); }
+  std::string dump_summary() const override { return this->name_; }
+
+  // Change the level, runs the change hook and the attached interrupt on an edge
+  void set_level(bool value);
+  bool level() const { return this->level_; }
+
+  std::function<void(bool)> on_change;
+
+ protected:
+  void attach_interrupt(void (*func)(void *), void *arg, gpio::InterruptType type) const override;
+
+  std::string name_;
+  bool level_{false};
+
+  mutable void (*isr_)(void *){nullptr};
+  mutable void *isr_arg_{nullptr};
+  mutable gpio::InterruptType isr_type_{gpio::INTERRUPT_ANY_EDGE};
+};
+
+typedef struct {
+  uint64_t time;  // host::time_us() at the end of the packet
+  uint32_t address;
+  uint16_t channel;
+  bool band;
+  std::vector<uint8_t> payload;
+} SimPacket;
+
+typedef struct {
+  uint32_t acquisitions;  // SPI bus acquisitions (enable/disable pairs)
+  uint32_t instructions;  // Instructions, i.e. CSN low periods
+  uint32_t bytes;         // Bytes clocked, including instruction bytes
+  uint32_t config_writes; // W_CONFIG instructions
+  uint32_t config_reads;  // R_CONFIG instructions
+  uint32_t payload_writes;
+  uint32_t rx_payload_reads;
+  uint32_t status_reads;  // NOP instructions
+  uint32_t channel_configs;
+  uint32_t copies_sent;   // Packets put on air
+  uint32_t copies_aborted; // Packets cut off by leaving TX while on air
+  uint32_t rx_delivered;  // Packets received into the RX payload register
+  uint32_t rx_overrun;    // Packets lost because DR was still set
+} SimStats;
+
+class nRF905Sim : public SpiBus {
+ public:
+  nRF905Sim();
+
+  // SpiBus
+  void acquire(uint32_t data_rate) override;
+  void transfer(uint8_t *data, size_t length) override;
+  void release() override;
+
+  // Advance the radio to the current host time; call after moving the clock
+  void step();
+
+  // A packet on the air; received when listening on the same channel with a matching address
+  void receive(const SimPacket &packet);
+
+  // Somebody else is using the channel
+  void set_carrier(bool busy);
+
+  // Highest SPI clock that works reliably, faster transfers get corrupted
+  void set_max_data_rate(uint32_t rate) { this->max_data_rate_ = rate; }
+  uint32_t data_rate() const { return this->data_rate_; }
+
+  uint32_t airtime_us() const;
+  uint16_t channel() const { return ((this->regs[1] & 0x01) << 8) | this->regs[0]; }
+  bool band() const { return (this->regs[1] & 0x02) != 0; }
+  uint32_t rx_address() const;
+  uint32_t tx_address() const;
+  bool listening() const;
+  bool transmitting() const;
+  // Start of the copy currently on air, 0 while not sending (settling counts as not on air)
+  uint64_t air_start() const;
+
+  SimPin pin_pwr{"PWR"};
+  SimPin pin_ce{"CE"};
+  SimPin pin_txen{"TXEN"};
+  SimPin pin_cs{"CS"};
+  SimPin pin_dr{"DR"};
+  SimPin pin_am{"AM"};
+  SimPin pin_cd{"CD"};
+
+  uint8_t regs[10];
+  uint8_t tx_payload[32];
+  uint8_t tx_addr[4];
+  uint8_t rx_payload[32];
+
+  SimStats stats;
+  std::vector<std::vector<uint8_t>> trace;  // MOSI bytes of every instruction, when tracing
+  bool tracing{false};
+
+  std::function<void(const SimPacket &)> on_transmit;
+
+ protected:
+  void on_cs(bool level);
+  void on_mode_pin();
+  uint8_t status() const;
+  uint8_t clock_byte(uint8_t mosi);
+  bool ready() const;
+
+  uint32_t data_rate_{0};
+  uint32_t max_data_rate_{10000000};
+  bool selected_{false};
+  size_t position_{0};
+  uint8_t command_{0};
+  std::vector<uint8_t> current_;
+
+  uint64_t power_up_at_{0};  // Time the chip is out of power down
+  uint64_t tx_end_at_{0};    // End of the packet on air, 0 when not sending
+  uint64_t rx_since_{0};     // Time receive mode was entered
+  bool rx_{false};
+};
+
+}  // namespace host
+}  // namespace esphome
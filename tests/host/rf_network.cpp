@@ -0,0 +1,569 @@
+#include "rf_network.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace esphome {
+namespace host {
+
+static const uint32_t NETWORK_ID = 0xA1B2C3D4;
+static const uint8_t MAIN_UNIT_ID = 0x42;
+static const uint8_t DEVICE_ID = 0x17;
+
+static const uint32_t TX_SETTLE_TIME = 650;     // Scripted nodes switch to TX like the nRF905 does
+static const uint32_t COPY_WINDOW = 100000;     // Copies of a frame closer together than this are one frame
+static const uint32_t DEFER_MIN = 1000;         // Backoff of a scripted node that found the channel busy
+static const uint32_t DEFER_MAX = 5000;
+static const uint64_t AIR_HISTORY = 200000;     // How long finished transmissions are kept for collision checks
+
+// Voltage the main unit runs at for each speed preset
+static const uint8_t SPEED_VOLTAGE[] = {0, 30, 50, 90, 100};
+
+NetworkScenario default_scenario() {
+  NetworkScenario scenario;
+
+  scenario.seed = 1;
+  scenario.loss = 0.0;
+  scenario.reply_delay_min = 5000;
+  scenario.reply_delay_max = 20000;
+  scenario.main_unit_copies = FAN_TX_FRAMES;
+  scenario.co2_sensors = 0;
+  scenario.remotes = 0;
+  scenario.competitor_interval = 60000;
+  scenario.competitor_lbt = true;
+  scenario.poll_interval = 30000;
+  scenario.poll_interval_min = 10000;
+  scenario.poll_interval_max = 300000;
+  scenario.passive_tracking = true;
+  scenario.set_speed_interval = 0;
+  scenario.paired = true;
+  scenario.loop_period = ESPHOME_LOOP_US;
+  scenario.duration = 600000;
+
+  return scenario;
+}
+
+uint32_t percentile(std::vector<uint32_t> samples, double p) {
+  size_t rank;
+
+  if (samples.empty()) {
+    return 0;
+  }
+  std::sort(samples.begin(), samples.end());
+  rank = (size_t) std::ceil(p / 100.0 * samples.size());
+
+  return samples[(rank > 0 ? rank : 1) - 1];
+}
+
+static void print_command(const char *name, const CommandStats &command) {
+  std::printf("  %-10s %6u %6u %6u %8u %8.1f %8.1f %8.1f %8.1f\n", name, command.count, command.ok, command.failed,
+              command.bursts > command.count ? command.bursts - command.count : 0,
+              percentile(command.latency, 50) / 1000.0, percentile(command.latency, 90) / 1000.0,
+              percentile(command.latency, 99) / 1000.0, percentile(command.latency, 100) / 1000.0);
+}
+
+void print_report(const NetworkScenario &scenario, const NetworkStats &stats) {
+  uint64_t total = 0;
+
+  std::printf("Scenario: seed %u, loss %.1f%%, reply delay %.1f-%.1f ms, %u CO2 sensors, %u remotes (every %u ms%s)\n",
+              scenario.seed, scenario.loss * 100.0, scenario.reply_delay_min / 1000.0,
+              scenario.reply_delay_max / 1000.0, scenario.co2_sensors, scenario.remotes,
+              scenario.competitor_interval, scenario.competitor_lbt ? ", listen before talk" : "");
+  std::printf("          poll every %u ms (%u - %u ms), %s, %.0f s simulated\n", scenario.poll_interval,
+              scenario.poll_interval_min, scenario.poll_interval_max, scenario.paired ? "paired" : "pairing", stats.duration / 1000000.0);
+  std::printf("          main loop every %.1f ms\n", (scenario.loop_period ? scenario.loop_period : LOOP_TICK_US) / 1000.0);
+
+  std::printf("\n  %-10s %6s %6s %6s %8s %8s %8s %8s %8s\n", "command", "count", "ok", "failed", "retries", "p50 ms",
+              "p90 ms", "p99 ms", "max ms");
+  print_command("query", stats.query);
+  print_command("set speed", stats.set_speed);
+  print_command("pairing", stats.pairing);
+
+  std::printf("\n  %-14s %8s %12s %8s\n", "node", "copies", "airtime ms", "duty %");
+  for (const NodeStats &node : stats.nodes) {
+    total += node.airtime;
+    std::printf("  %-14s %8u %12.1f %8.3f\n", node.name.c_str(), node.copies, node.airtime / 1000.0,
+                stats.duration ? node.airtime * 100.0 / stats.duration : 0.0);
+  }
+  std::printf("  %-14s %8s %12.1f %8.3f\n", "channel", "", total / 1000.0,
+              stats.duration ? total * 100.0 / stats.duration : 0.0);
+
+  std::printf("\n  collisions %u, losses %u, deferrals %u\n", stats.collisions, stats.losses, stats.deferrals);
+}
+
+static std::vector<uint8_t> make_frame(uint8_t rx_type, uint8_t rx_id, uint8_t tx_type, uint8_t tx_id, uint8_t command,
+                                       std::initializer_list<uint8_t> parameters) {
+  std::vector<uint8_t> frame(FAN_FRAMESIZE, 0);
+  size_t i = 7;
+
+  frame[0] = rx_type;
+  frame[1] = rx_id;
+  frame[2] = tx_type;
+  frame[3] = tx_id;
+  frame[4] = FAN_TTL;
+  frame[5] = command;
+  frame[6] = (uint8_t) parameters.size();
+  for (uint8_t parameter : parameters) {
+    frame[i++] = parameter;
+  }
+
+  return frame;
+}
+
+static uint32_t get_u32(const std::vector<uint8_t> &frame, size_t offset) {
+  return frame[offset] | (frame[offset + 1] << 8) | (frame[offset + 2] << 16) | ((uint32_t) frame[offset + 3] << 24);
+}
+
+RfNode::RfNode(RfNetwork *network, const std::string &name, uint8_t type, uint8_t id)
+    : network_(network), name_(name), type_(type), id_(id) {}
+
+MainUnit::MainUnit(RfNetwork *network, uint8_t id, uint32_t network_id)
+    : RfNode(network, "main unit", zehnder::FAN_TYPE_MAIN_UNIT, id), network_id_(network_id) {}
+
+bool MainUnit::listens_on(uint32_t address) const {
+  return (address == this->network_id_) || (this->join_open_ && (address == NETWORK_LINK_ID));
+}
+
+std::vector<uint8_t> MainUnit::settings_for(uint8_t rx_type, uint8_t rx_id) const {
+  auto it = this->linked_.find(rx_id);
+
+  if (it != this->linked_.end()) {
+    rx_type = it->second;
+  }
+
+  return make_frame(rx_type, rx_id, this->type_, this->id_, zehnder::FAN_TYPE_FAN_SETTINGS,
+                    {this->speed, this->voltage, this->timer});
+}
+
+void MainUnit::receive(const SimPacket &packet) {
+  const std::vector<uint8_t> &f = packet.payload;
+  const uint8_t rxType = f[0], rxId = f[1], txType = f[2], txId = f[3], command = f[5];
+  const uint32_t id = this->network_id_;
+  std::vector<uint8_t> response;
+  uint32_t address = this->network_id_;
+
+  if ((f == this->last_frame_) && ((packet.time - this->last_frame_end_) < COPY_WINDOW)) {
+    // Another copy of the frame already handled, answer after this one
+    this->last_frame_end_ = packet.time;
+    if (this->reply_at_ != 0) {
+      this->reply(0, {});
+    }
+    return;
+  }
+  this->last_frame_ = f;
+  this->last_frame_end_ = packet.time;
+  this->reply_at_ = 0;
+
+  if (packet.address == NETWORK_LINK_ID) {
+    if (command == zehnder::FAN_NETWORK_JOIN_ACK) {
+      // A device is looking for a network, offer ours
+      response = make_frame(txType, txId, this->type_, this->id_, zehnder::FAN_NETWORK_JOIN_OPEN,
+                            {(uint8_t) id, (uint8_t) (id >> 8), (uint8_t) (id >> 16), (uint8_t) (id >> 24)});
+      address = NETWORK_LINK_ID;
+    }
+  } else if ((rxType == this->type_) && ((rxId == this->id_) || (rxId == 0x00))) {
+    switch (command) {
+      case zehnder::FAN_TYPE_QUERY_DEVICE:
+        response = this->settings_for(txType, txId);
+        break;
+
+      case zehnder::FAN_FRAME_SETSPEED:
+        this->speed = f[7] <= zehnder::FAN_SPEED_MAX ? f[7] : (uint8_t) zehnder::FAN_SPEED_MAX;
+        this->voltage = SPEED_VOLTAGE[this->speed];
+        this->timer = 0;
+        response = this->settings_for(txType, txId);
+        break;
+
+      case zehnder::FAN_FRAME_SETTIMER:
+        this->speed = f[7] <= zehnder::FAN_SPEED_MAX ? f[7] : (uint8_t) zehnder::FAN_SPEED_MAX;
+        this->voltage = SPEED_VOLTAGE[this->speed];
+        this->timer = f[8];
+        response = this->settings_for(txType, txId);
+        break;
+
+      case zehnder::FAN_FRAME_SETVOLTAGE:
+        this->voltage = f[7] <= 100 ? f[7] : 100;
+        response = this->settings_for(txType, txId);
+        break;
+
+      case zehnder::FAN_NETWORK_JOIN_REQUEST:
+        if (this->join_open_ && (get_u32(f, 7) == id)) {
+          this->link(txType, txId);
+          response = make_frame(txType, txId, this->type_, this->id_, zehnder::FAN_FRAME_0B, {});
+        }
+        break;
+
+      case zehnder::FAN_FRAME_0B:
+        if (this->join_open_) {
+          // Link acknowledged, confirm the device is part of the network
+          response = make_frame(this->type_, this->id_, this->type_, this->id_, zehnder::FAN_TYPE_QUERY_NETWORK, {});
+          this->join_open_ = false;
+          this->paired_ = true;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if (!response.empty()) {
+    this->reply(address, response);
+  }
+}
+
+void MainUnit::reply(uint32_t address, const std::vector<uint8_t> &frame) {
+  const NetworkScenario &scenario = this->network_->scenario();
+  std::uniform_int_distribution<uint32_t> delay(scenario.reply_delay_min, scenario.reply_delay_max);
+  uint32_t generation = ++this->reply_generation_;
+
+  if (!frame.empty()) {
+    this->reply_address_ = address;
+    this->reply_frame_ = frame;
+  }
+
+  this->reply_at_ = this->last_frame_end_ + delay(this->network_->rng());
+  this->network_->schedule(this->reply_at_, [this, generation]() {
+    if (generation != this->reply_generation_) {
+      return;  // Pushed back by a later copy
+    }
+    this->reply_at_ = 0;
+    this->network_->transmit(this, this->reply_address_, this->reply_frame_, this->network_->scenario().main_unit_copies,
+                            true);
+  });
+}
+
+CompetingDevice::CompetingDevice(RfNetwork *network, const std::string &name, uint8_t type, uint8_t id,
+                                 uint32_t network_id)
+    : RfNode(network, name, type, id), network_id_(network_id) {}
+
+void CompetingDevice::start() {
+  std::exponential_distribution<double> interval(1.0 / this->network_->scenario().competitor_interval);
+
+  this->network_->schedule(time_us() + (uint64_t) (interval(this->network_->rng()) * 1000.0), [this]() {
+    this->send();
+    this->start();
+  });
+}
+
+void CompetingDevice::send() {
+  std::uniform_int_distribution<uint32_t> level(zehnder::FAN_SPEED_LOW, zehnder::FAN_SPEED_HIGH);
+  std::vector<uint8_t> frame;
+
+  if (this->type_ == zehnder::FAN_TYPE_CO2_SENSOR) {
+    frame = make_frame(zehnder::FAN_TYPE_MAIN_UNIT, 0x00, this->type_, this->id_, zehnder::FAN_FRAME_SETSPEED,
+                       {(uint8_t) level(this->network_->rng())});
+  } else {
+    frame = make_frame(zehnder::FAN_TYPE_MAIN_UNIT, 0x00, this->type_, this->id_, zehnder::FAN_FRAME_SETTIMER,
+                       {(uint8_t) level(this->network_->rng()), 10});
+  }
+
+  this->network_->transmit(this, this->network_id_, frame, FAN_TX_FRAMES, this->network_->scenario().competitor_lbt);
+}
+
+RfNetwork::RfNetwork(const NetworkScenario &scenario)
+    : main_unit(this, MAIN_UNIT_ID, NETWORK_ID), scenario_(scenario), rng_(scenario.seed) {
+  char name[32];
+
+  this->stats_.query = CommandStats();
+  this->stats_.set_speed = CommandStats();
+  this->stats_.pairing = CommandStats();
+  this->stats_.collisions = 0;
+  this->stats_.losses = 0;
+  this->stats_.deferrals = 0;
+  this->stats_.duration = 0;
+
+  this->nodes_.push_back(nullptr);
+  this->stats_.nodes.push_back({"device", 0, 0});
+  this->add_node(&this->main_unit);
+
+  for (uint8_t i = 0; i < scenario.co2_sensors; ++i) {
+    std::snprintf(name, sizeof(name), "co2 sensor %u", i + 1);
+    this->competitors_.emplace_back(
+        new CompetingDevice(this, name, zehnder::FAN_TYPE_CO2_SENSOR, 0x60 + i, NETWORK_ID));
+  }
+  for (uint8_t i = 0; i < scenario.remotes; ++i) {
+    std::snprintf(name, sizeof(name), "remote %u", i + 1);
+    this->competitors_.emplace_back(
+        new CompetingDevice(this, name, zehnder::FAN_TYPE_TIMER_REMOTE_CONTROL, 0x80 + i, NETWORK_ID));
+  }
+  for (auto &device : this->competitors_) {
+    this->add_node(device.get());
+  }
+}
+
+void RfNetwork::add_node(RfNode *node) {
+  node->index_ = this->nodes_.size();
+  this->nodes_.push_back(node);
+  this->stats_.nodes.push_back({node->name(), 0, 0});
+}
+
+void RfNetwork::schedule(uint64_t time, std::function<void()> action) {
+  this->events_.push({time, this->seq_++, std::move(action)});
+}
+
+bool RfNetwork::channel_busy(uint64_t time) {
+  if (this->bench.sim.air_start() != 0) {
+    return true;
+  }
+  for (const Transmission &tx : this->air_) {
+    if ((tx.start <= time) && (time < tx.end)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void RfNetwork::transmit(RfNode *node, uint32_t address, const std::vector<uint8_t> &frame, uint8_t copies,
+                         bool lbt) {
+  uint64_t now = time_us();
+  uint64_t start = now + TX_SETTLE_TIME;
+
+  if (lbt && this->channel_busy(now)) {
+    std::uniform_int_distribution<uint32_t> backoff(DEFER_MIN, DEFER_MAX);
+
+    ++this->stats_.deferrals;
+    this->schedule(now + backoff(this->rng_),
+                   [this, node, address, frame, copies, lbt]() { this->transmit(node, address, frame, copies, lbt); });
+    return;
+  }
+
+  for (uint8_t i = 0; i < copies; ++i) {
+    Transmission tx;
+
+    tx.start = start;
+    tx.end = start + this->airtime_;
+    tx.node = node->index();
+    tx.packet.time = tx.end;
+    tx.packet.address = address;
+    tx.packet.channel = this->bench.sim.channel();
+    tx.packet.band = this->bench.sim.band();
+    tx.packet.payload = frame;
+    this->air_.push_back(tx);
+
+    ++this->stats_.nodes[tx.node].copies;
+    this->stats_.nodes[tx.node].airtime += this->airtime_;
+
+    this->schedule(tx.end, [this, tx]() { this->deliver(tx); });
+    start = tx.end;
+  }
+}
+
+bool RfNetwork::collides(const Transmission &tx) const {
+  uint64_t deviceStart = this->bench.sim.air_start();
+
+  // The copy the device is sending right now, it is not in the history until it has ended
+  if ((tx.node != 0) && (deviceStart != 0) && (deviceStart < tx.end)) {
+    return true;
+  }
+  for (const Transmission &other : this->air_) {
+    if (((other.node != tx.node) || (other.start != tx.start)) && (other.start < tx.end) && (tx.start < other.end)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool RfNetwork::lost() {
+  std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+  if ((this->scenario_.loss > 0.0) && (chance(this->rng_) < this->scenario_.loss)) {
+    ++this->stats_.losses;
+    return true;
+  }
+
+  return false;
+}
+
+void RfNetwork::deliver(const Transmission &tx) {
+  if (this->collides(tx)) {
+    ++this->stats_.collisions;
+    return;
+  }
+
+  if ((tx.node != 0) && !this->lost()) {
+    this->bench.sim.receive(tx.packet);
+  }
+
+  for (size_t i = 1; i < this->nodes_.size(); ++i) {
+    RfNode *node = this->nodes_[i];
+    bool sending = false;
+
+    if ((i == tx.node) || !node->listens_on(tx.packet.address)) {
+      continue;
+    }
+    // Half duplex, a node does not hear anything while it is sending itself
+    for (const Transmission &own : this->air_) {
+      if ((own.node == i) && (own.start < tx.end) && (tx.start < own.end)) {
+        sending = true;
+        break;
+      }
+    }
+    if (!sending && !this->lost()) {
+      node->receive(tx.packet);
+    }
+  }
+}
+
+void RfNetwork::on_device_copy(const SimPacket &packet) {
+  Transmission tx;
+
+  tx.start = packet.time - this->airtime_;
+  tx.end = packet.time;
+  tx.node = 0;
+  tx.packet = packet;
+
+  // Auto retransmitted copies follow each other without a gap
+  if (tx.start != this->device_last_copy_end_) {
+    ++this->device_bursts_;
+  }
+  this->device_last_copy_end_ = tx.end;
+
+  ++this->stats_.nodes[0].copies;
+  this->stats_.nodes[0].airtime += this->airtime_;
+
+  this->air_.push_back(tx);
+  this->deliver(tx);
+}
+
+void RfNetwork::run_events() {
+  uint64_t now = time_us();
+
+  while (!this->events_.empty() && (this->events_.top().time <= now)) {
+    Event event = this->events_.top();
+
+    this->events_.pop();
+    event.action();
+  }
+}
+
+void RfNetwork::prune() {
+  uint64_t now = time_us();
+
+  this->air_.erase(std::remove_if(this->air_.begin(), this->air_.end(),
+                                  [now](const Transmission &tx) { return (tx.end + AIR_HISTORY) < now; }),
+                   this->air_.end());
+}
+
+void RfNetwork::track_commands() {
+  TestZehnderRF::Phase phase = this->bench.fan.phase();
+  CommandStats *command = nullptr;
+  bool ok = false;
+
+  if (phase == this->phase_) {
+    return;
+  }
+
+  // End of the command that was running
+  switch (this->phase_) {
+    case TestZehnderRF::PhaseQuery:
+      command = &this->stats_.query;
+      ok = this->bench.fan.settings_received() != this->command_settings_;
+      break;
+    case TestZehnderRF::PhaseSetSpeed:
+      command = &this->stats_.set_speed;
+      ok = this->bench.fan.settings_received() != this->command_settings_;
+      break;
+    case TestZehnderRF::PhasePairing:
+      command = &this->stats_.pairing;
+      ok = phase == TestZehnderRF::PhaseIdle;
+      break;
+    default:
+      break;
+  }
+  if (command != nullptr) {
+    ++command->count;
+    command->bursts += this->device_bursts_ - this->command_bursts_;
+    if (ok) {
+      ++command->ok;
+      command->latency.push_back((uint32_t) (time_us() - this->command_start_));
+    } else {
+      ++command->failed;
+    }
+  }
+
+  this->phase_ = phase;
+  this->command_start_ = time_us();
+  this->command_bursts_ = this->device_bursts_;
+  this->command_settings_ = this->bench.fan.settings_received();
+}
+
+NetworkStats RfNetwork::run() {
+  const uint64_t end = (uint64_t) this->scenario_.duration * 1000;
+  uint64_t nextPrune = 0;
+
+  seed_random(this->scenario_.seed);
+
+  this->bench.fan.set_update_interval(this->scenario_.poll_interval);
+  this->bench.fan.set_update_interval_min(this->scenario_.poll_interval_min);
+  this->bench.fan.set_update_interval_max(this->scenario_.poll_interval_max);
+  this->bench.fan.set_passive_tracking(this->scenario_.passive_tracking);
+  this->bench.sim.on_transmit = [this](const SimPacket &packet) { this->on_device_copy(packet); };
+  this->bench.on_step = [this]() {
+    this->run_events();
+
+    // Carrier detect sees the other nodes, not the device's own transmissions
+    this->bench.sim.set_carrier([this]() {
+      uint64_t now = time_us();
+
+      for (const Transmission &tx : this->air_) {
+        if ((tx.node != 0) && (tx.start <= now) && (now < tx.end)) {
+          return true;
+        }
+      }
+      return false;
+    }());
+  };
+  this->bench.set_loop_period(this->scenario_.loop_period);
+  this->bench.setup();
+  this->airtime_ = this->bench.sim.airtime_us();
+
+  for (auto &device : this->competitors_) {
+    this->main_unit.link(device->type_, device->id_);
+  }
+  if (this->scenario_.paired) {
+    this->main_unit.link(zehnder::FAN_TYPE_REMOTE_CONTROL, DEVICE_ID);
+    this->bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, DEVICE_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                               MAIN_UNIT_ID);
+  } else {
+    this->main_unit.open_join();
+  }
+
+  for (auto &device : this->competitors_) {
+    device->start();
+  }
+
+  if (this->scenario_.set_speed_interval != 0) {
+    std::exponential_distribution<double> interval(1.0 / this->scenario_.set_speed_interval);
+    std::uniform_int_distribution<uint32_t> level(zehnder::FAN_SPEED_LOW, zehnder::FAN_SPEED_MAX);
+    uint64_t at = 0;
+
+    // The user changes the speed now and then
+    while ((at += (uint64_t) (interval(this->rng_) * 1000.0)) < end) {
+      uint8_t speed = (uint8_t) level(this->rng_);
+
+      this->schedule(at, [this, speed]() { this->bench.fan.setSpeed(speed); });
+    }
+  }
+
+  // The channel and the chip are stepped every 100 us, the main loop only every loop period
+  while (time_us() < end) {
+    this->bench.tick();
+    this->track_commands();
+
+    if (time_us() >= nextPrune) {
+      this->prune();
+      nextPrune = time_us() + AIR_HISTORY;
+    }
+  }
+
+  this->stats_.duration = end;
+
+  return this->stats_;
+}
+
+}  // namespace host
+}  // namespace esphome
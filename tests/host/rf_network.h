@@ -0,0 +1,217 @@
+// Discrete-event model of the 868 MHz channel around a host built ZehnderRF
+//
+// The device under test is the FanBench (ZehnderRF + nRF905 driver + register level simulator), stepped by the
+// simulated main loop. Everything else on the channel is scripted: a Zehnder main unit that answers queries, speed
+// commands and the pairing sequence, and competing CO2 sensors and remotes. Every copy of every frame is one
+// transmission on the channel; transmissions that overlap in time collide and are lost for every receiver, and each
+// receiver independently loses a copy with the configured probability.
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "harness.h"
+
+namespace esphome {
+namespace host {
+
+typedef struct {
+  uint32_t seed;
+  double loss;                // Probability that a receiver misses a copy
+  uint32_t reply_delay_min;   // Main unit processing time after the last copy it heard, in us
+  uint32_t reply_delay_max;
+  uint8_t main_unit_copies;   // Copies the main unit sends of each frame
+  uint8_t co2_sensors;        // Competing devices on the same network
+  uint8_t remotes;
+  uint32_t competitor_interval;  // Mean time between frames of one competing device, in ms
+  bool competitor_lbt;           // Competing devices check the channel before sending
+  uint32_t poll_interval;        // ZehnderRF update interval, in ms
+  uint32_t poll_interval_min;    // Bounds of the adaptive polling, in ms
+  uint32_t poll_interval_max;
+  bool passive_tracking;         // ZehnderRF follows settings the main unit sends to others
+  uint32_t set_speed_interval;   // Mean time between speed changes requested by the user, 0 for none, in ms
+  bool paired;                   // Start paired, otherwise the main unit is opened for pairing
+  uint32_t loop_period;          // ESPHome main loop period, 0 to run it on every 100 us step, in us
+  uint32_t duration;             // Simulated time, in ms
+} NetworkScenario;
+
+NetworkScenario default_scenario();
+
+typedef struct {
+  uint32_t count;
+  uint32_t ok;
+  uint32_t failed;
+  uint32_t bursts;                // Transmissions (groups of copies) sent by the device for these commands
+  std::vector<uint32_t> latency;  // Of the commands that got their reply, in us
+} CommandStats;
+
+typedef struct {
+  std::string name;
+  uint32_t copies;
+  uint64_t airtime;  // us
+} NodeStats;
+
+typedef struct {
+  CommandStats query;
+  CommandStats set_speed;
+  CommandStats pairing;
+  std::vector<NodeStats> nodes;  // Device under test first
+  uint32_t collisions;           // Copies lost to an overlapping transmission
+  uint32_t losses;               // Copies lost by a single receiver
+  uint32_t deferrals;            // Scripted transmissions postponed by a busy channel
+  uint64_t duration;             // us
+} NetworkStats;
+
+// Percentile (0..100) of the samples, nearest rank
+uint32_t percentile(std::vector<uint32_t> samples, double p);
+
+void print_report(const NetworkScenario &scenario, const NetworkStats &stats);
+
+class RfNetwork;
+
+// A scripted node on the channel
+class RfNode {
+ public:
+  RfNode(RfNetwork *network, const std::string &name, uint8_t type, uint8_t id);
+  virtual ~RfNode() = default;
+
+  // A copy that made it to this node, only called while listening on its address
+  virtual void receive(const SimPacket &) {}
+  virtual bool listens_on(uint32_t) const { return false; }
+
+  const std::string &name() const { return this->name_; }
+  size_t index() const { return this->index_; }
+
+ protected:
+  friend class RfNetwork;
+
+  RfNetwork *network_;
+  std::string name_;
+  uint8_t type_;
+  uint8_t id_;
+  size_t index_{0};
+};
+
+class MainUnit : public RfNode {
+ public:
+  MainUnit(RfNetwork *network, uint8_t id, uint32_t network_id);
+
+  void receive(const SimPacket &packet) override;
+  bool listens_on(uint32_t address) const override;
+
+  void open_join() { this->join_open_ = true; }
+  // A device that is part of the network; replies go to the type it linked with, whatever type it sends as
+  void link(uint8_t type, uint8_t id) { this->linked_[id] = type; }
+  bool paired() const { return this->paired_; }
+
+  uint8_t speed{zehnder::FAN_SPEED_MEDIUM};
+  uint8_t voltage{50};
+  uint8_t timer{0};
+
+ protected:
+  void reply(uint32_t address, const std::vector<uint8_t> &frame);
+  std::vector<uint8_t> settings_for(uint8_t rx_type, uint8_t rx_id) const;
+
+  uint32_t network_id_;
+  std::map<uint8_t, uint8_t> linked_;  // Device id to type
+  bool join_open_{false};
+  bool paired_{false};
+
+  // Copies of one frame are handled once; the reply goes out after the last copy heard
+  std::vector<uint8_t> last_frame_;
+  uint64_t last_frame_end_{0};
+  uint64_t reply_at_{0};
+  uint32_t reply_generation_{0};
+  uint32_t reply_address_{0};
+  std::vector<uint8_t> reply_frame_;
+};
+
+// CO2 sensor or remote that talks to the main unit now and then
+class CompetingDevice : public RfNode {
+ public:
+  CompetingDevice(RfNetwork *network, const std::string &name, uint8_t type, uint8_t id, uint32_t network_id);
+
+  void start();
+
+ protected:
+  void send();
+
+  uint32_t network_id_;
+};
+
+class RfNetwork {
+ public:
+  explicit RfNetwork(const NetworkScenario &scenario);
+
+  // Runs the scenario to the end and returns the statistics
+  NetworkStats run();
+
+  // Used by the scripted nodes
+  void schedule(uint64_t time, std::function<void()> action);
+  void transmit(RfNode *node, uint32_t address, const std::vector<uint8_t> &frame, uint8_t copies, bool lbt);
+  bool channel_busy(uint64_t time);
+  std::mt19937 &rng() { return this->rng_; }
+  const NetworkScenario &scenario() const { return this->scenario_; }
+  uint32_t airtime() const { return this->airtime_; }
+
+  FanBench bench;
+  MainUnit main_unit;
+
+ protected:
+  typedef struct {
+    uint64_t time;
+    uint64_t seq;
+    std::function<void()> action;
+  } Event;
+
+  struct EventLater {
+    bool operator()(const Event &a, const Event &b) const {
+      return (a.time != b.time) ? (a.time > b.time) : (a.seq > b.seq);
+    }
+  };
+
+  typedef struct {
+    uint64_t start;
+    uint64_t end;
+    size_t node;  // Index in nodes_, 0 is the device under test
+    SimPacket packet;
+  } Transmission;
+
+  void add_node(RfNode *node);
+  void run_events();
+  void deliver(const Transmission &tx);
+  void on_device_copy(const SimPacket &packet);
+  bool collides(const Transmission &tx) const;
+  bool lost();
+  void track_commands();
+  void prune();
+
+  NetworkScenario scenario_;
+  std::mt19937 rng_;
+  std::priority_queue<Event, std::vector<Event>, EventLater> events_;
+  uint64_t seq_{0};
+
+  std::vector<RfNode *> nodes_;  // Index 0 is a placeholder for the device under test
+  std::vector<std::unique_ptr<CompetingDevice>> competitors_;
+  std::vector<Transmission> air_;  // Recent transmissions, for collision checks
+  uint32_t airtime_{0};
+  uint64_t device_last_copy_end_{0};
+
+  NetworkStats stats_;
+
+  // Command tracking
+  TestZehnderRF::Phase phase_{TestZehnderRF::PhaseStartup};
+  uint64_t command_start_{0};
+  uint32_t command_bursts_{0};
+  uint32_t command_settings_{0};
+  uint32_t device_bursts_{0};
+};
+
+}  // namespace host
+}  // namespace esphome
@@ -0,0 +1,80 @@
+// Host build stand-in for esphome/components/fan/fan.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+
+template<typename T> class optional {
+ public:
+  optional() = default;
+  optional(T value) : has_value_(true), value_(value) {}
+
+  bool has_value() const { return this->has_value_; }
+  const T &operator*() const { return this->value_; }
+
+ private:
+  bool has_value_{false};
+  T value_{};
+};
+
+namespace fan {
+
+class FanTraits {
+ public:
+  FanTraits() = default;
+  FanTraits(bool oscillation, bool speed, bool direction, int speed_count)
+      : oscillation_(oscillation), speed_(speed), direction_(direction), speed_count_(speed_count) {}
+
+  int supported_speed_count() const { return this->speed_count_; }
+
+ protected:
+  bool oscillation_{false};
+  bool speed_{false};
+  bool direction_{false};
+  int speed_count_{};
+};
+
+class FanCall {
+ public:
+  FanCall &set_state(bool state) {
+    this->state_ = state;
+    return *this;
+  }
+  FanCall &set_speed(int speed) {
+    this->speed_ = speed;
+    return *this;
+  }
+
+  optional<bool> get_state() const { return this->state_; }
+  optional<int> get_speed() const { return this->speed_; }
+
+ protected:
+  optional<bool> state_;
+  optional<int> speed_;
+};
+
+class Fan {
+ public:
+  virtual ~Fan() = default;
+
+  bool state{false};
+  int speed{0};
+
+  void publish_state() { ++this->publish_count; }
+  std::string get_name() const { return "host"; }
+
+  virtual FanTraits get_traits() = 0;
+
+  // Host only: number of publish_state() calls
+  uint32_t publish_count{0};
+
+ protected:
+  virtual void control(const FanCall &call) = 0;
+};
+
+}  // namespace fan
+}  // namespace esphome
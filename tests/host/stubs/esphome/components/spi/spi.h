@@ -0,0 +1,84 @@
+// Host build stand-in for esphome/components/spi/spi.h
+// SPI traffic is handed to the installed host::SpiBus, e.g. the nRF905 simulator
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "esphome/core/gpio.h"
+
+namespace esphome {
+namespace spi {
+
+enum SPIBitOrder {
+  BIT_ORDER_LSB_FIRST,
+  BIT_ORDER_MSB_FIRST,
+};
+
+enum SPIClockPolarity {
+  CLOCK_POLARITY_LOW = false,
+  CLOCK_POLARITY_HIGH = true,
+};
+
+enum SPIClockPhase {
+  CLOCK_PHASE_LEADING,
+  CLOCK_PHASE_TRAILING,
+};
+
+enum SPIDataRate : uint32_t {
+  DATA_RATE_1KHZ = 1000,
+  DATA_RATE_200KHZ = 200000,
+  DATA_RATE_1MHZ = 1000000,
+  DATA_RATE_2MHZ = 2000000,
+  DATA_RATE_4MHZ = 4000000,
+  DATA_RATE_5MHZ = 5000000,
+  DATA_RATE_8MHZ = 8000000,
+  DATA_RATE_10MHZ = 10000000,
+  DATA_RATE_20MHZ = 20000000,
+};
+
+}  // namespace spi
+
+namespace host {
+
+class SpiBus {
+ public:
+  virtual ~SpiBus() = default;
+
+  virtual void acquire(uint32_t data_rate) = 0;
+  virtual void transfer(uint8_t *data, size_t length) = 0;
+  virtual void release() = 0;
+};
+
+extern SpiBus *spi_bus;
+
+}  // namespace host
+
+namespace spi {
+
+template<SPIBitOrder BIT_ORDER, SPIClockPolarity CLOCK_POLARITY, SPIClockPhase CLOCK_PHASE, SPIDataRate DATA_RATE>
+class SPIDevice {
+ public:
+  void spi_setup() {}
+  void spi_teardown() {}
+
+  void set_data_rate(uint32_t data_rate) { this->data_rate_ = data_rate; }
+  void set_cs_pin(GPIOPin *cs) { this->cs_ = cs; }
+
+  void enable() {
+    host::spi_bus->acquire(this->data_rate_);
+    this->cs_->digital_write(false);
+  }
+  void disable() {
+    this->cs_->digital_write(true);
+    host::spi_bus->release();
+  }
+  void transfer_array(uint8_t *data, size_t length) { host::spi_bus->transfer(data, length); }
+
+ protected:
+  uint32_t data_rate_{DATA_RATE};
+  GPIOPin *cs_{nullptr};
+};
+
+}  // namespace spi
+}  // namespace esphome
@@ -0,0 +1,4 @@
+// Host build stand-in for esphome/core/application.h
+#pragma once
+
+#include "esphome/core/component.h"
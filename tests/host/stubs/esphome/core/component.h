@@ -0,0 +1,33 @@
+// Host build stand-in for esphome/core/component.h
+#pragma once
+
+#include <cstdint>
+
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+
+namespace setup_priority {
+
+const float HARDWARE = 800.0f;
+const float DATA = 600.0f;
+
+}  // namespace setup_priority
+
+class Component {
+ public:
+  virtual ~Component() = default;
+
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return 0.0f; }
+
+  void mark_failed() { this->failed_ = true; }
+  bool is_failed() const { return this->failed_; }
+
+ protected:
+  bool failed_{false};
+};
+
+}  // namespace esphome
@@ -0,0 +1,58 @@
+// Host build stand-in for esphome/core/gpio.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace esphome {
+namespace gpio {
+
+enum InterruptType : uint8_t {
+  INTERRUPT_RISING_EDGE = 1,
+  INTERRUPT_FALLING_EDGE = 2,
+  INTERRUPT_ANY_EDGE = 3,
+};
+
+}  // namespace gpio
+
+class GPIOPin {
+ public:
+  virtual ~GPIOPin() = default;
+  virtual void setup() {}
+  virtual bool digital_read() = 0;
+  virtual void digital_write(bool value) = 0;
+  virtual std::string dump_summary() const { return "host"; }
+};
+
+class InternalGPIOPin;
+
+// Pin handle for use from interrupt handlers; on the host it just forwards to the pin
+class ISRInternalGPIOPin {
+ public:
+  ISRInternalGPIOPin() = default;
+  explicit ISRInternalGPIOPin(void *arg) : arg_(arg) {}
+  bool digital_read();
+  void digital_write(bool value);
+
+ protected:
+  void *arg_{nullptr};
+};
+
+class InternalGPIOPin : public GPIOPin {
+ public:
+  virtual ISRInternalGPIOPin to_isr() const { return ISRInternalGPIOPin(const_cast<InternalGPIOPin *>(this)); }
+  template<typename T> void attach_interrupt(void (*func)(T *), T *arg, gpio::InterruptType type) const {
+    this->attach_interrupt(reinterpret_cast<void (*)(void *)>(func), reinterpret_cast<void *>(arg), type);
+  }
+  virtual void detach_interrupt() const {}
+
+ protected:
+  virtual void attach_interrupt(void (*func)(void *), void *arg, gpio::InterruptType type) const = 0;
+};
+
+inline bool ISRInternalGPIOPin::digital_read() { return static_cast<InternalGPIOPin *>(this->arg_)->digital_read(); }
+inline void ISRInternalGPIOPin::digital_write(bool value) {
+  static_cast<InternalGPIOPin *>(this->arg_)->digital_write(value);
+}
+
+}  // namespace esphome
@@ -0,0 +1,33 @@
+// Host build stand-in for esphome/core/hal.h
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include "esphome/core/gpio.h"
+
+#define IRAM_ATTR
+#define HOT
+
+namespace esphome {
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+namespace host {
+
+// Simulated clock, only moves when the test advances it
+uint64_t time_us();
+void set_time_us(uint64_t us);
+void advance_us(uint64_t us);
+
+void seed_random(uint32_t seed);
+
+}  // namespace host
+}  // namespace esphome
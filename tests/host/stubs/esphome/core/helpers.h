@@ -0,0 +1,12 @@
+// Host build stand-in for esphome/core/helpers.h
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace esphome {
+
+uint32_t fnv1_hash(const std::string &str);
+uint32_t random_uint32();
+
+}  // namespace esphome
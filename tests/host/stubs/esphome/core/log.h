@@ -0,0 +1,33 @@
+// Host build stand-in for esphome/core/log.h, prints to stdout when enabled
+#pragma once
+
+#include <cstdio>
+
+namespace esphome {
+namespace host {
+
+extern bool log_enabled;
+
+}  // namespace host
+}  // namespace esphome
+
+#define ESP_LOG_HOST(level, tag, format, ...) \
+  do { \
+    if (::esphome::host::log_enabled) { \
+      std::printf("[" level "][%s] " format "\n", tag, ##__VA_ARGS__); \
+    } \
+  } while (0)
+
+#define ESP_LOGE(tag, ...) ESP_LOG_HOST("E", tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESP_LOG_HOST("W", tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ESP_LOG_HOST("I", tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ESP_LOG_HOST("D", tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ESP_LOG_HOST("V", tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ESP_LOG_HOST("C", tag, __VA_ARGS__)
+
+#define LOG_PIN(prefix, pin) \
+  do { \
+    if ((pin) != nullptr) { \
+      ESP_LOGCONFIG(TAG, prefix " %s", (pin)->dump_summary().c_str()); \
+    } \
+  } while (0)
@@ -0,0 +1,56 @@
+// Host build stand-in for esphome/core/preferences.h, keeps preferences in memory
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace esphome {
+
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() = default;
+  explicit ESPPreferenceObject(uint32_t key) : key_(key) {}
+
+  template<typename T> bool save(const T *src);
+  template<typename T> bool load(T *dest);
+
+ protected:
+  uint32_t key_{0};
+};
+
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t key, bool in_flash = false) {
+    (void) in_flash;
+    return ESPPreferenceObject(key);
+  }
+
+  std::map<uint32_t, std::vector<uint8_t>> store;
+  uint32_t save_count{0};
+};
+
+extern ESPPreferences *global_preferences;
+
+template<typename T> bool ESPPreferenceObject::save(const T *src) {
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(src);
+
+  global_preferences->store[this->key_].assign(data, data + sizeof(T));
+  ++global_preferences->save_count;
+
+  return true;
+}
+
+template<typename T> bool ESPPreferenceObject::load(T *dest) {
+  auto it = global_preferences->store.find(this->key_);
+
+  if ((it == global_preferences->store.end()) || (it->second.size() != sizeof(T))) {
+    return false;
+  }
+  std::memcpy(dest, it->second.data(), sizeof(T));
+
+  return true;
+}
+
+}  // namespace esphome
@@ -0,0 +1,57 @@
+// Host implementations of the ESPHome core functions the components use
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+#include "esphome/components/spi/spi.h"
+
+namespace esphome {
+
+namespace host {
+
+bool log_enabled = false;
+SpiBus *spi_bus = nullptr;
+
+static uint64_t now_us = 0;
+static uint32_t random_state = 1;
+
+uint64_t time_us() { return now_us; }
+void set_time_us(uint64_t us) { now_us = us; }
+void advance_us(uint64_t us) { now_us += us; }
+
+void seed_random(uint32_t seed) { random_state = (seed != 0) ? seed : 1; }
+
+}  // namespace host
+
+uint32_t millis() { return (uint32_t) (host::now_us / 1000); }
+uint32_t micros() { return (uint32_t) host::now_us; }
+void delay(uint32_t ms) { host::now_us += (uint64_t) ms * 1000; }
+void delayMicroseconds(uint32_t us) { host::now_us += us; }
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= c;
+  }
+
+  return hash;
+}
+
+uint32_t random_uint32() {
+  // xorshift32, deterministic so simulation runs can be repeated
+  uint32_t x = host::random_state;
+
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  host::random_state = x;
+
+  return x;
+}
+
+static ESPPreferences preferences;
+ESPPreferences *global_preferences = &preferences;
+
+}  // namespace esphome
@@ -0,0 +1,139 @@
+// Host tests for the Zehnder frame codec (zehnder_frame.h), without radio or component
+#include <cstring>
+
+#include "check.h"
+#include "esphome/components/zehnder/zehnder_frame.h"
+
+using namespace esphome;
+using namespace esphome::zehnder;
+
+static constexpr RfAddress ADDRESS = {FAN_TYPE_MAIN_UNIT, 0x42, FAN_TYPE_REMOTE_CONTROL, 0x17};
+
+// Frames can be built at compile time
+static constexpr uint8_t encodedByte(const uint8_t index) {
+  uint8_t frame[FAN_FRAMESIZE] = {0};
+
+  rfFrameEncode(frame, ADDRESS, RfPayloadNetworkJoinAck{0xA55A5AA5});
+  return frame[index];
+}
+static_assert(encodedByte(5) == FAN_NETWORK_JOIN_ACK, "Command not encoded");
+static_assert(encodedByte(7) == 0xA5 && encodedByte(8) == 0x5A && encodedByte(9) == 0x5A && encodedByte(10) == 0xA5,
+              "Network ID not little endian");
+
+static void test_encode_layout() {
+  uint8_t frame[FAN_FRAMESIZE];
+  static const uint8_t expected[FAN_FRAMESIZE] = {
+      0x01, 0x42, 0x03, 0x17, 0xFA, 0x04, 0x04, 0xD4, 0xC3, 0xB2, 0xA1, 0x00, 0x00, 0x00, 0x00, 0x00,
+  };
+
+  std::memset(frame, 0xEE, sizeof(frame));
+  rfFrameEncode(frame, ADDRESS, RfPayloadNetworkJoinRequest{0xA1B2C3D4});
+  CHECK(std::memcmp(frame, expected, sizeof(frame)) == 0);
+}
+
+static void test_encode_parameter_counts() {
+  uint8_t frame[FAN_FRAMESIZE];
+
+  rfFrameEncode(frame, ADDRESS, RfPayloadQueryDevice{});
+  CHECK_EQ(frame[5], FAN_TYPE_QUERY_DEVICE);
+  CHECK_EQ(frame[6], 0);
+
+  rfFrameEncode(frame, ADDRESS, RfPayloadFanSetSpeed{0x03});
+  CHECK_EQ(frame[5], FAN_FRAME_SETSPEED);
+  CHECK_EQ(frame[6], 1);
+  CHECK_EQ(frame[7], 0x03);
+  CHECK_EQ(frame[8], 0);
+
+  rfFrameEncode(frame, ADDRESS, RfPayloadFanSetTimer{0x04, 30});
+  CHECK_EQ(frame[6], 2);
+  CHECK_EQ(frame[7], 0x04);
+  CHECK_EQ(frame[8], 30);
+
+  rfFrameEncode(frame, ADDRESS, RfPayloadSetSpeedReply{});
+  CHECK_EQ(frame[5], FAN_FRAME_SETSPEED_REPLY);
+  CHECK_EQ(frame[6], 3);
+  CHECK_EQ(frame[7], 0x54);
+  CHECK_EQ(frame[8], 0x03);
+  CHECK_EQ(frame[9], 0x20);
+}
+
+static void test_round_trip() {
+  uint8_t frame[FAN_FRAMESIZE];
+  RfFrame decoded;
+  RfPayloadFanSettings settings;
+
+  rfFrameEncode(frame, ADDRESS, RfPayloadFanSettings{0x02, 50, 10});
+  CHECK_EQ(rfFrameDecode(frame, sizeof(frame), &decoded), RfFrameOk);
+  CHECK_EQ(decoded.rx_type, FAN_TYPE_MAIN_UNIT);
+  CHECK_EQ(decoded.rx_id, 0x42);
+  CHECK_EQ(decoded.tx_type, FAN_TYPE_REMOTE_CONTROL);
+  CHECK_EQ(decoded.tx_id, 0x17);
+  CHECK_EQ(decoded.ttl, FAN_TTL);
+  CHECK_EQ(decoded.command, FAN_TYPE_FAN_SETTINGS);
+
+  settings = decoded.payload<RfPayloadFanSettings>();
+  CHECK_EQ(settings.speed, 0x02);
+  CHECK_EQ(settings.voltage, 50);
+  CHECK_EQ(settings.timer, 10);
+
+  rfFrameEncode(frame, ADDRESS, RfPayloadNetworkJoinOpen{0x01020304});
+  CHECK_EQ(rfFrameDecode(frame, sizeof(frame), &decoded), RfFrameOk);
+  CHECK_EQ(decoded.payload<RfPayloadNetworkJoinOpen>().networkId, 0x01020304);
+}
+
+static void test_decode_rejects() {
+  uint8_t frame[FAN_FRAMESIZE + 16] = {0};
+  RfFrame decoded;
+
+  rfFrameEncode(frame, ADDRESS, RfPayloadFanSettings{0x01, 30, 0});
+  CHECK_EQ(rfFrameDecode(frame, FAN_FRAMESIZE - 1, &decoded), RfFrameTooShort);
+  CHECK_EQ(rfFrameDecode(frame, 0, &decoded), RfFrameTooShort);
+
+  // Longer frames (32 byte payload width) are fine, the tail is ignored
+  CHECK_EQ(rfFrameDecode(frame, sizeof(frame), &decoded), RfFrameOk);
+
+  // Truncated and oversized settings
+  frame[6] = 2;
+  CHECK_EQ(rfFrameDecode(frame, FAN_FRAMESIZE, &decoded), RfFrameBadParameterCount);
+  frame[6] = 4;
+  CHECK_EQ(rfFrameDecode(frame, FAN_FRAMESIZE, &decoded), RfFrameBadParameterCount);
+
+  // Join offer without its full network ID
+  rfFrameEncode(frame, ADDRESS, RfPayloadNetworkJoinOpen{0xA1B2C3D4});
+  frame[6] = 3;
+  CHECK_EQ(rfFrameDecode(frame, FAN_FRAMESIZE, &decoded), RfFrameBadParameterCount);
+
+  // Unknown layouts are only bounded by the frame
+  rfFrameEncode(frame, ADDRESS, RfPayloadLinkSuccess{});
+  frame[6] = FAN_FRAME_PARAMETERS_MAX;
+  CHECK_EQ(rfFrameDecode(frame, FAN_FRAMESIZE, &decoded), RfFrameOk);
+  frame[6] = FAN_FRAME_PARAMETERS_MAX + 1;
+  CHECK_EQ(rfFrameDecode(frame, FAN_FRAMESIZE, &decoded), RfFrameBadParameterCount);
+  frame[5] = 0x7F;
+  frame[6] = 0xFF;
+  CHECK_EQ(rfFrameDecode(frame, FAN_FRAMESIZE, &decoded), RfFrameBadParameterCount);
+}
+
+static void test_parameter_count_table() {
+  CHECK_EQ(rfFrameParameterCount(FAN_FRAME_SETSPEED), RfPayloadFanSetSpeed::PARAMETER_COUNT);
+  CHECK_EQ(rfFrameParameterCount(FAN_FRAME_SETTIMER), RfPayloadFanSetTimer::PARAMETER_COUNT);
+  CHECK_EQ(rfFrameParameterCount(FAN_TYPE_FAN_SETTINGS), RfPayloadFanSettings::PARAMETER_COUNT);
+  CHECK_EQ(rfFrameParameterCount(FAN_NETWORK_JOIN_OPEN), RfPayloadNetworkJoinOpen::PARAMETER_COUNT);
+  CHECK_EQ(rfFrameParameterCount(FAN_NETWORK_JOIN_REQUEST), RfPayloadNetworkJoinRequest::PARAMETER_COUNT);
+  CHECK_EQ(rfFrameParameterCount(FAN_NETWORK_JOIN_ACK), RfPayloadNetworkJoinAck::PARAMETER_COUNT);
+  CHECK_EQ(rfFrameParameterCount(FAN_TYPE_QUERY_DEVICE), 0);
+  CHECK_EQ(rfFrameParameterCount(FAN_FRAME_0B), FAN_FRAME_PARAMETERS_ANY);
+  CHECK_EQ(rfFrameParameterCount(0xFF), FAN_FRAME_PARAMETERS_ANY);
+}
+
+int main() {
+  static const host::TestCase cases[] = {
+      {"encode layout", test_encode_layout},
+      {"encode parameter counts", test_encode_parameter_counts},
+      {"round trip", test_round_trip},
+      {"decode rejects", test_decode_rejects},
+      {"parameter count table", test_parameter_count_table},
+  };
+
+  return host::run_tests(cases, sizeof(cases) / sizeof(cases[0]));
+}
@@ -0,0 +1,1130 @@
+// Host tests for the nRF905 driver and ZehnderRF, run against the register level simulator
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include "check.h"
+#include "harness.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+static const uint32_t NETWORK_ID = 0xA1B2C3D4;
+static const uint8_t MAIN_UNIT_ID = 0x42;
+static const uint8_t MY_ID = 0x17;
+
+// Heap allocations made while counting is on
+static bool countAllocations = false;
+static uint32_t allocations = 0;
+
+void *operator new(size_t size) {
+  void *p;
+
+  if (countAllocations) {
+    ++allocations;
+  }
+  p = std::malloc(size != 0 ? size : 1);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  return p;
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+static std::vector<uint8_t> settings_frame(uint8_t speed, uint8_t voltage, uint8_t timer) {
+  std::vector<uint8_t> frame(16, 0);
+
+  frame[0] = zehnder::FAN_TYPE_REMOTE_CONTROL;  // rx type
+  frame[1] = MY_ID;                             // rx id
+  frame[2] = zehnder::FAN_TYPE_MAIN_UNIT;       // tx type
+  frame[3] = MAIN_UNIT_ID;                      // tx id
+  frame[4] = FAN_TTL;
+  frame[5] = zehnder::FAN_TYPE_FAN_SETTINGS;
+  frame[6] = 3;
+  frame[7] = speed;
+  frame[8] = voltage;
+  frame[9] = timer;
+
+  return frame;
+}
+
+static void test_setup_configures_chip() {
+  RadioBench bench;
+
+  bench.setup();
+
+  CHECK_EQ(bench.sim.channel(), 118);
+  CHECK(bench.sim.band());
+  CHECK_EQ(bench.sim.rx_address(), 0x89816EA9);
+  CHECK_EQ(bench.sim.tx_address(), 0x89816EA9);
+  CHECK_EQ(bench.sim.regs[3], 16);  // RX payload width
+  CHECK_EQ(bench.sim.regs[4], 16);  // TX payload width
+  CHECK_EQ(bench.rf.getMode(), nrf905::Idle);
+}
+
+static void test_config_diff_write() {
+  RadioBench bench;
+  nrf905::Config config;
+
+  bench.setup();
+  bench.sim.tracing = true;
+  std::memset(&bench.sim.stats, 0, sizeof(bench.sim.stats));
+
+  // Unchanged config: no bus traffic at all
+  config = bench.rf.getConfig();
+  bench.rf.updateConfig(&config);
+  CHECK_EQ(bench.sim.stats.instructions, 0);
+
+  // Only the RX address changes: write registers 5..8 and read them back
+  config.rx_address = NETWORK_ID;
+  bench.rf.updateConfig(&config);
+  CHECK_EQ(bench.sim.stats.config_writes, 1);
+  CHECK_EQ(bench.sim.stats.config_reads, 1);
+  CHECK_EQ(bench.sim.trace.size(), 2);
+  CHECK_EQ(bench.sim.trace[0][0], NRF905_COMMAND_W_CONFIG | 5);
+  CHECK_EQ(bench.sim.trace[0].size(), 5);
+  CHECK_EQ(bench.sim.rx_address(), NETWORK_ID);
+}
+
+static void test_channel_config_fast_path() {
+  RadioBench bench;
+
+  bench.setup();
+  std::memset(&bench.sim.stats, 0, sizeof(bench.sim.stats));
+
+  bench.rf.writeChannelConfig(117, true, 6);
+  CHECK_EQ(bench.sim.stats.instructions, 1);
+  CHECK_EQ(bench.sim.stats.channel_configs, 1);
+  CHECK_EQ(bench.sim.channel(), 117);
+  CHECK_EQ((bench.sim.regs[1] >> 2) & 0x03, 0x02);  // 6 dBm
+
+  // The shadow is in sync: going back is another single instruction
+  bench.rf.writeChannelConfig(118, true, 10);
+  CHECK_EQ(bench.sim.stats.instructions, 2);
+  CHECK_EQ(bench.sim.channel(), 118);
+}
+
+static void test_idle_loop_without_spi() {
+  RadioBench bench;
+
+  bench.setup();
+  bench.rf.setMode(nrf905::Receive);
+  std::memset(&bench.sim.stats, 0, sizeof(bench.sim.stats));
+
+  bench.run_us(100000);
+  CHECK_EQ(bench.sim.stats.instructions, 0);
+}
+
+static void test_idle_loop_polls_without_pins() {
+  RadioBench bench(false);
+
+  bench.setup();
+  std::memset(&bench.sim.stats, 0, sizeof(bench.sim.stats));
+
+  bench.run_us(10 * LOOP_TICK_US);
+  CHECK_EQ(bench.sim.stats.status_reads, 10);
+}
+
+static void test_rx_frame_queued() {
+  RadioBench bench;
+  SimPacket packet;
+  nrf905::RxFrame frame;
+  uint32_t bytes;
+
+  bench.setup();
+  bench.rf.setMode(nrf905::Receive);
+  bench.run_us(5000);
+
+  packet.address = 0x89816EA9;
+  packet.channel = 118;
+  packet.band = true;
+  packet.payload = settings_frame(2, 50, 0);
+
+  bytes = bench.sim.stats.bytes;
+  bench.sim.receive(packet);
+  bench.tick();
+
+  // Only the 16 configured payload bytes plus the instruction
+  CHECK_EQ(bench.sim.stats.bytes - bytes, 17);
+  CHECK(bench.rf.readRxFrame(&frame));
+  CHECK_EQ(frame.length, 16);
+  CHECK(std::memcmp(frame.data, packet.payload.data(), 16) == 0);
+  CHECK(!bench.rf.readRxFrame(&frame));
+  CHECK_EQ(bench.rf.getRxHighWaterMark(), 1);
+}
+
+static void test_rx_queue_overflow() {
+  RadioBench bench;
+  SimPacket packet;
+  nrf905::RxFrame frame;
+  uint32_t count = 0;
+
+  bench.setup();
+  bench.rf.setMode(nrf905::Receive);
+  bench.run_us(5000);
+
+  packet.address = 0x89816EA9;
+  packet.channel = 118;
+  packet.band = true;
+  packet.payload = settings_frame(1, 30, 0);
+
+  for (int i = 0; i < NRF905_RX_QUEUE_SIZE + 2; ++i) {
+    bench.sim.receive(packet);
+    bench.tick();
+  }
+
+  CHECK_EQ(bench.rf.getRxOverflowCount(), 2);
+  CHECK_EQ(bench.rf.getRxHighWaterMark(), NRF905_RX_QUEUE_SIZE);
+  while (bench.rf.readRxFrame(&frame)) {
+    ++count;
+  }
+  CHECK_EQ(count, NRF905_RX_QUEUE_SIZE);
+}
+
+static void test_rx_callback_drains_queue() {
+  RadioBench bench;
+  SimPacket packet;
+  nrf905::RxFrame frame;
+  uint32_t received = 0;
+
+  bench.setup();
+  bench.rf.setOnRxComplete([&received](const uint8_t *const pBuffer, const uint8_t size) {
+    received += (size == 16) && (pBuffer[7] == 2);
+  });
+  bench.rf.setMode(nrf905::Receive);
+  bench.run_us(5000);
+
+  packet.address = 0x89816EA9;
+  packet.channel = 118;
+  packet.band = true;
+  packet.payload = settings_frame(2, 50, 0);
+
+  for (int i = 0; i < NRF905_RX_QUEUE_SIZE + 2; ++i) {
+    bench.sim.receive(packet);
+    bench.tick();
+  }
+
+  // Every frame goes through the queue to the callback, so the queue statistics hold for callback consumers too
+  CHECK_EQ(received, NRF905_RX_QUEUE_SIZE + 2);
+  CHECK_EQ(bench.rf.getRxOverflowCount(), 0);
+  CHECK_EQ(bench.rf.getRxHighWaterMark(), 1);
+  CHECK_EQ(bench.rf.getRxPending(), 0);
+  CHECK(!bench.rf.readRxFrame(&frame));
+}
+
+static void test_tx_auto_retransmit() {
+  RadioBench bench;
+  uint8_t payload[16] = {0x01, 0x42, 0x03, 0x17, 0xFA, 0x10};
+  uint32_t txReady = 0;
+
+  bench.setup();
+  bench.rf.setOnTxReady([&txReady]() { ++txReady; });
+  bench.rf.writeTxPayload(payload, sizeof(payload));
+
+  bench.rf.startTx(4, nrf905::Receive);
+  bench.run_us(50000);
+
+  CHECK_EQ(bench.sim.stats.copies_sent, 4);
+  CHECK_EQ(txReady, 1);
+  CHECK_EQ(bench.rf.getMode(), nrf905::Receive);
+  CHECK(!bench.rf.getConfig().auto_retransmit || (bench.sim.regs[1] & 0x20));
+
+  // A single copy clears the retransmit flag again
+  bench.rf.startTx(1, nrf905::Receive);
+  bench.run_us(50000);
+  CHECK_EQ(bench.sim.stats.copies_sent, 5);
+  CHECK_EQ(bench.sim.regs[1] & 0x20, 0);
+  CHECK_EQ(txReady, 2);
+}
+
+static void test_tx_auto_retransmit_polling() {
+  RadioBench bench(false);
+  uint8_t payload[16] = {0};
+  uint32_t txReady = 0;
+
+  bench.setup();
+  bench.rf.setOnTxReady([&txReady]() { ++txReady; });
+  bench.rf.writeTxPayload(payload, sizeof(payload));
+
+  bench.rf.startTx(4, nrf905::Receive);
+  bench.run_us(50000);
+
+  CHECK_EQ(bench.sim.stats.copies_sent, 4);
+  CHECK_EQ(txReady, 1);
+}
+
+static void test_tx_copies_without_dr_slow_loop() {
+  RadioBench bench(false);
+  uint8_t payload[16] = {0x01, 0x42, 0x03, 0x17, 0xFA, 0x10};
+  uint32_t txReady = 0;
+
+  // Without DR nothing stops auto retransmit in time at a real loop period, so every copy is sent on its own
+  bench.set_loop_period(ESPHOME_LOOP_US);
+  bench.setup();
+  bench.rf.setOnTxReady([&txReady]() { ++txReady; });
+  bench.rf.writeTxPayload(payload, sizeof(payload));
+
+  bench.rf.startTx(4, nrf905::Receive);
+  bench.run_us(200000);
+
+  CHECK_EQ(bench.sim.stats.copies_sent, 4);
+  CHECK_EQ(bench.sim.stats.copies_aborted, 0);
+  CHECK_EQ(bench.sim.regs[1] & 0x20, 0);
+  CHECK_EQ(txReady, 1);
+  CHECK_EQ(bench.rf.getMode(), nrf905::Receive);
+}
+
+static void test_tx_auto_retransmit_slow_loop() {
+  RadioBench bench;
+  uint8_t payload[16] = {0x01, 0x42, 0x03, 0x17, 0xFA, 0x10};
+  uint32_t txReady = 0;
+  uint64_t lastCopy = 0;
+  SimPacket reply;
+
+  // A real main loop comes round every 16 ms, several copies apart
+  bench.set_loop_period(ESPHOME_LOOP_US);
+  bench.setup();
+  bench.rf.setOnTxReady([&txReady]() { ++txReady; });
+  bench.rf.writeTxPayload(payload, sizeof(payload));
+  bench.sim.on_transmit = [&lastCopy](const SimPacket &packet) { lastCopy = packet.time; };
+
+  bench.rf.startTx(4, nrf905::Receive);
+  while ((bench.sim.stats.copies_sent < 4) && (time_us() < 200000)) {
+    bench.tick();
+  }
+
+  // Answered 1 ms after the last copy, whether or not the loop came round in between
+  reply.address = bench.sim.rx_address();
+  reply.channel = bench.sim.channel();
+  reply.band = bench.sim.band();
+  reply.payload.assign(payload, payload + sizeof(payload));
+  bench.run_us((lastCopy + 1000) - time_us());
+  bench.sim.receive(reply);
+  bench.run_us(100000);
+
+  CHECK_EQ(bench.sim.stats.copies_sent, 4);
+  CHECK_EQ(bench.sim.stats.rx_delivered, 1);
+  CHECK_EQ(txReady, 1);
+  CHECK_EQ(bench.rf.getMode(), nrf905::Receive);
+}
+
+static void test_tx_from_power_down_does_not_block() {
+  RadioBench bench;
+  uint8_t payload[16] = {0};
+  uint64_t start;
+
+  bench.setup();
+  bench.rf.setMode(nrf905::PowerDown);
+  bench.rf.writeTxPayload(payload, sizeof(payload));
+
+  start = time_us();
+  bench.rf.startTx(1, nrf905::Idle);
+  CHECK_EQ(time_us(), start);
+  CHECK_EQ(bench.rf.getTransition(), nrf905::PoweringUp);
+  CHECK_EQ(bench.sim.stats.copies_sent, 0);
+
+  bench.run_us(2000);
+  CHECK_EQ(bench.rf.getMode(), nrf905::Idle);  // Still powering up
+  bench.run_us(8000);
+  CHECK_EQ(bench.sim.stats.copies_sent, 1);
+}
+
+static void test_spi_self_test_fallback() {
+  RadioBench bench;
+
+  bench.sim.set_max_data_rate(spi::DATA_RATE_4MHZ);
+  bench.rf.set_data_rate(spi::DATA_RATE_10MHZ);
+  bench.setup();
+
+  CHECK_EQ(bench.rf.data_rate(), spi::DATA_RATE_4MHZ);
+  CHECK_EQ(bench.sim.rx_address(), 0x89816EA9);
+}
+
+static void test_batched_register_access() {
+  RadioBench bench;
+  uint8_t payload[16] = {0};
+  nrf905::Config config;
+  uint32_t ceEdges = 0;
+  auto onCe = bench.sim.pin_ce.on_change;
+
+  bench.setup();
+  bench.rf.setMode(nrf905::Receive);
+  bench.sim.pin_ce.on_change = [&](bool level) {
+    ++ceEdges;
+    onCe(level);
+  };
+
+  // Three register accesses, one trip through standby
+  bench.rf.beginBatch();
+  config = bench.rf.getConfig();
+  config.rx_address = NETWORK_ID;
+  bench.rf.updateConfig(&config);
+  bench.rf.writeTxAddress(NETWORK_ID);
+  bench.rf.writeTxPayload(payload, sizeof(payload));
+  CHECK_EQ(bench.rf.getMode(), nrf905::Idle);
+  bench.rf.endBatch();
+
+  CHECK_EQ(ceEdges, 2);
+  CHECK_EQ(bench.rf.getMode(), nrf905::Receive);
+  CHECK_EQ(bench.sim.rx_address(), NETWORK_ID);
+  CHECK_EQ(bench.sim.tx_address(), NETWORK_ID);
+}
+
+static void test_tx_payload_unchanged_skipped() {
+  RadioBench bench;
+  uint8_t payload[16] = {0x01, 0x42, 0x03, 0x17};
+  uint8_t readBack[16];
+
+  bench.setup();
+  std::memset(&bench.sim.stats, 0, sizeof(bench.sim.stats));
+
+  bench.rf.writeTxPayload(payload, sizeof(payload));
+  bench.rf.writeTxPayload(payload, sizeof(payload));
+  CHECK_EQ(bench.sim.stats.payload_writes, 1);
+  CHECK_EQ(bench.sim.stats.instructions, 1);
+  CHECK_EQ(bench.rf.getTxPayloadSkipCount(), 1);
+
+  // A different frame, or one that only differs past the payload width, is uploaded
+  payload[15] = 0x01;
+  bench.rf.writeTxPayload(payload, sizeof(payload));
+  CHECK_EQ(bench.sim.stats.payload_writes, 2);
+  bench.rf.writeTxPayload(payload, sizeof(payload) - 1);
+  CHECK_EQ(bench.sim.stats.payload_writes, 3);
+  CHECK_EQ(bench.sim.tx_payload[15], 0x00);
+
+  // Reading it back keeps the shadow in sync
+  bench.rf.readTxPayload(readBack, sizeof(readBack));
+  bench.rf.writeTxPayload(payload, sizeof(payload) - 1);
+  CHECK_EQ(bench.sim.stats.payload_writes, 3);
+  CHECK_EQ(bench.rf.getTxPayloadSkipCount(), 2);
+
+  // The payload register does not survive power down, the same frame is uploaded again afterwards
+  bench.rf.setMode(nrf905::PowerDown);
+  bench.rf.setMode(nrf905::Idle);
+  bench.rf.writeTxPayload(payload, sizeof(payload) - 1);
+  CHECK_EQ(bench.sim.stats.payload_writes, 4);
+  CHECK_EQ(bench.sim.tx_payload[0], payload[0]);
+}
+
+static void test_fan_query_cycle() {
+  FanBench bench;
+  uint32_t queries = 0;
+  bool replied = false;
+  SimPacket reply;
+
+  // Paired with a main unit (as the pairing service would, before startup ends); it answers a query with its
+  // current settings
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    if ((packet.payload[5] == zehnder::FAN_TYPE_QUERY_DEVICE) && !replied) {
+      ++queries;
+      replied = true;
+      reply.address = NETWORK_ID;
+      reply.channel = packet.channel;
+      reply.band = packet.band;
+      reply.payload = settings_frame(3, 90, 0);
+      reply.time = packet.time + 20000;
+    }
+  };
+
+  while (time_us() < 16000000ULL) {
+    bench.tick();
+    if (replied && (reply.time != 0) && (time_us() >= reply.time)) {
+      bench.sim.receive(reply);
+      reply.time = 0;
+    }
+  }
+
+  CHECK_EQ(queries, 1);
+  CHECK_EQ(bench.fan.speed, 3);
+  CHECK_EQ(bench.fan.voltage, 90);
+  CHECK(bench.fan.state);
+  CHECK(bench.fan.connection_healthy_);
+  CHECK_EQ(bench.sim.rx_address(), NETWORK_ID);
+}
+
+static void test_fan_repeated_polls_upload_once() {
+  FanBench bench;
+  uint32_t queries = 0;
+  SimPacket reply;
+
+  bench.fan.set_update_interval(2000);
+  bench.fan.set_update_interval_max(2000);  // No backing off, every poll counts here
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+
+  // The main unit answers every query (the last copy of it)
+  reply.time = 0;
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    if (packet.payload[5] == zehnder::FAN_TYPE_QUERY_DEVICE) {
+      ++queries;
+      reply.address = NETWORK_ID;
+      reply.channel = packet.channel;
+      reply.band = packet.band;
+      reply.payload = settings_frame(2, 50, 0);
+      reply.time = packet.time + 20000;
+    }
+  };
+
+  while (time_us() < 15000000ULL) {
+    bench.tick();
+  }
+  std::memset(&bench.sim.stats, 0, sizeof(bench.sim.stats));
+
+  while (time_us() < 25000000ULL) {
+    bench.tick();
+    if ((reply.time != 0) && (time_us() >= reply.time)) {
+      bench.sim.receive(reply);
+      reply.time = 0;
+    }
+  }
+
+  CHECK(queries >= 4 * FAN_TX_FRAMES);
+  CHECK_EQ(bench.sim.stats.payload_writes, 1);
+  CHECK_EQ(bench.fan.speed, 2);
+
+  // A speed command loads another frame, as soon as the RF engine picks it up
+  bench.fan.setSpeed(zehnder::FAN_SPEED_HIGH, 0);
+  bench.tick();
+  CHECK_EQ(bench.sim.stats.payload_writes, 2);
+  CHECK_EQ(bench.sim.tx_payload[5], zehnder::FAN_FRAME_SETSPEED);
+}
+
+static void test_fan_commands_coalesce_and_preempt_poll() {
+  FanBench bench;
+  std::vector<std::vector<uint8_t>> sent;  // Distinct frames, in order
+  uint32_t queryCopies = 0;
+
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    queryCopies += (packet.payload[5] == zehnder::FAN_TYPE_QUERY_DEVICE);
+    if (sent.empty() || (sent.back() != packet.payload)) {
+      sent.push_back(packet.payload);
+    }
+  };
+
+  // The main unit stays silent, so the first poll is retrying when a burst of commands comes in
+  while ((time_us() < 20000000ULL) && ((bench.fan.phase() != TestZehnderRF::PhaseQuery) ||
+                                       (bench.fan.retries() < 0) || (bench.fan.retries() == FAN_TX_RETRIES))) {
+    bench.tick();
+  }
+  CHECK_EQ(bench.fan.phase(), TestZehnderRF::PhaseQuery);
+  bench.fan.setSpeed(1);
+  bench.fan.setSpeed(2);
+  bench.fan.setSpeed(3, 10);
+  CHECK_EQ(bench.fan.commands_pending(), 1);
+
+  // Sent instead of the poll's retry, only the last one
+  bench.run_us(2000000);
+  CHECK_EQ(queryCopies, FAN_TX_FRAMES);
+  CHECK_EQ(bench.fan.phase(), TestZehnderRF::PhaseSetSpeed);
+  CHECK_EQ(bench.fan.commands_pending(), 0);
+  CHECK_EQ(sent.size(), 2);
+  if (sent.size() == 2) {
+    CHECK_EQ(sent[0][5], zehnder::FAN_TYPE_QUERY_DEVICE);
+    CHECK_EQ(sent[1][5], zehnder::FAN_FRAME_SETTIMER);
+    CHECK_EQ(sent[1][7], 3);
+    CHECK_EQ(sent[1][8], 10);
+  }
+}
+
+static void test_fan_stale_command_dropped() {
+  FanBench bench;
+  bool speedSent = false;
+
+  bench.fan.set_command_max_age(5000);
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    speedSent |= (packet.payload[5] == zehnder::FAN_FRAME_SETSPEED);
+  };
+
+  // Busy with something else for longer than the command may wait
+  bench.run_us(1000000);
+  bench.fan.force_state(2);  // Waiting for a pairing offer
+  bench.fan.setSpeed(2);
+  CHECK_EQ(bench.fan.commands_pending(), 1);
+  bench.run_us(6000000);
+  bench.fan.force_idle();
+  bench.run_us(1000000);
+
+  CHECK(!speedSent);
+  CHECK_EQ(bench.fan.commands_dropped(), 1);
+  CHECK_EQ(bench.fan.commands_pending(), 0);
+}
+
+static void test_fan_replaced_command_restarts_age() {
+  FanBench bench;
+  uint8_t speedSent = 0;
+
+  bench.fan.set_command_max_age(5000);
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    if (packet.payload[5] == zehnder::FAN_FRAME_SETSPEED) {
+      speedSent = packet.payload[7];
+    }
+  };
+
+  // Replaced just before the first request would have gone stale: the latest one is sent
+  bench.run_us(1000000);
+  bench.fan.force_state(2);  // Waiting for a pairing offer
+  bench.fan.setSpeed(1);
+  bench.run_us(4500000);
+  bench.fan.setSpeed(3);
+  bench.run_us(1000000);
+  bench.fan.force_idle();
+  bench.run_us(1000000);
+
+  CHECK_EQ(speedSent, 3);
+  CHECK_EQ(bench.fan.commands_dropped(), 0);
+}
+
+static void test_fan_repeated_copies_handled_once() {
+  FanBench bench;
+  std::vector<uint8_t> frame = settings_frame(3, 90, 0);
+  uint32_t publishes;
+
+  bench.fan.set_passive_tracking(true);  // Settings sent to another remote count as well
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+  bench.run_us(1000000);
+  bench.fan.force_idle();
+  publishes = bench.fan.publish_count;
+
+  // The main unit answering another remote, every copy back to back
+  frame[1] = 0x33;
+  for (uint8_t copy = 0; copy < FAN_TX_FRAMES; ++copy) {
+    bench.fan.rfHandleReceived(frame.data(), frame.size());
+    bench.run_us(4000);
+  }
+  CHECK_EQ(bench.fan.publish_count, publishes + 1);
+  CHECK_EQ(bench.fan.speed, 3);
+  CHECK_EQ(bench.fan.getRxFrameCount(), 1);
+  CHECK_EQ(bench.fan.getRxDuplicateCount(), FAN_TX_FRAMES - 1);
+
+  // The same settings a while later are a new frame, but nothing to publish
+  bench.run_us((FAN_DEDUP_WINDOW + 50) * 1000);
+  bench.fan.rfHandleReceived(frame.data(), frame.size());
+  CHECK_EQ(bench.fan.publish_count, publishes + 1);
+  CHECK_EQ(bench.fan.getRxFrameCount(), 2);
+
+  // Another sender or other parameters are not copies
+  frame[9] = 10;
+  bench.fan.rfHandleReceived(frame.data(), frame.size());
+  CHECK_EQ(bench.fan.getRxFrameCount(), 3);
+  CHECK(bench.fan.timer);
+}
+
+static void test_fan_publishes_changes_only() {
+  FanBench bench;
+  std::vector<uint8_t> frame = settings_frame(2, 50, 0);
+  uint32_t publishes;
+
+  frame[1] = 0x33;  // Overheard, so polling does not get in the way
+  bench.fan.set_passive_tracking(true);
+  bench.fan.set_update_interval(0xFFFFFFFF);
+  bench.fan.set_publish_min_interval(5000);
+  bench.fan.set_publish_heartbeat(60000);
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+  bench.fan.force_idle();
+  publishes = bench.fan.publish_count;
+
+  bench.fan.rfHandleReceived(frame.data(), frame.size());
+  CHECK_EQ(bench.fan.publish_count, publishes + 1);
+
+  // Unchanged
+  bench.run_us(1000000);
+  bench.fan.rfHandleReceived(frame.data(), frame.size());
+  CHECK_EQ(bench.fan.publish_count, publishes + 1);
+  CHECK_EQ(bench.fan.getPublishSuppressedCount(), 1);
+
+  // Two changes within the minimum interval end up in one publish of the latest state
+  frame[7] = 3;
+  frame[8] = 90;
+  bench.fan.rfHandleReceived(frame.data(), frame.size());
+  bench.run_us(1000000);
+  frame[9] = 30;
+  bench.fan.rfHandleReceived(frame.data(), frame.size());
+  CHECK_EQ(bench.fan.publish_count, publishes + 1);
+  bench.run_us(3500000);
+  CHECK_EQ(bench.fan.publish_count, publishes + 2);
+  CHECK_EQ(bench.fan.speed, 3);
+  CHECK(bench.fan.timer);
+
+  // Nothing new for a minute, the heartbeat repeats it
+  bench.run_us(55000000);
+  CHECK_EQ(bench.fan.publish_count, publishes + 2);
+  bench.run_us(6000000);
+  CHECK_EQ(bench.fan.publish_count, publishes + 3);
+  CHECK_EQ(bench.fan.getPublishCount(), 3);
+}
+
+static void test_fan_rf_task_slow_main_loop() {
+  FanBench bench;
+  uint32_t queries = 0;
+  SimPacket reply;
+
+  // Main loop held up for 50 ms at a time, by the web server say
+  bench.enable_rf_task(50000);
+  bench.fan.set_update_interval(10000);
+  bench.fan.set_update_interval_max(10000);
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+
+  reply.time = 0;
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    if (packet.payload[5] == zehnder::FAN_TYPE_QUERY_DEVICE) {
+      ++queries;
+      reply.address = NETWORK_ID;
+      reply.channel = packet.channel;
+      reply.band = packet.band;
+      reply.payload = settings_frame(3, 90, 0);
+      reply.time = packet.time + 20000;
+    }
+  };
+
+  while (time_us() < 60000000ULL) {
+    bench.tick();
+    if ((reply.time != 0) && (time_us() >= reply.time)) {
+      bench.sim.receive(reply);
+      reply.time = 0;
+    }
+  }
+
+  // Every poll answered at the first attempt, the round trip measured by the radio side and not the main loop
+  CHECK(queries >= 4 * FAN_TX_FRAMES);
+  CHECK(queries <= 6 * FAN_TX_FRAMES);  // Polls from 15 s on, no more than one every 9 s
+  CHECK_EQ(bench.fan.speed, 3);
+  CHECK(bench.fan.getReplyRtt() >= 19);
+  CHECK(bench.fan.getReplyRtt() <= 22);
+  CHECK(bench.fan.connection_healthy_);
+}
+
+static void test_fan_broadcast_rtt_main_unit() {
+  FanBench bench;
+  bool requested = false;
+  SimPacket reply;
+
+  bench.fan.set_update_interval(10000);
+  bench.fan.set_update_interval_max(10000);
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+
+  // Only the broadcast speed command, made just after startup, is answered: by the main unit 20 ms after it went out
+  reply.time = 0;
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    if (packet.payload[5] == zehnder::FAN_FRAME_SETSPEED) {
+      CHECK_EQ(packet.payload[1], 0x00);
+      reply.address = NETWORK_ID;
+      reply.channel = packet.channel;
+      reply.band = packet.band;
+      reply.payload = settings_frame(packet.payload[7], 70, 0);
+      reply.time = packet.time + 20000;
+    }
+  };
+
+  while (time_us() < 20000000ULL) {
+    bench.tick();
+    if ((reply.time != 0) && (time_us() >= reply.time)) {
+      bench.sim.receive(reply);
+      reply.time = 0;
+    }
+    if (!requested && (time_us() >= 16000000ULL)) {
+      bench.fan.setSpeed(2);
+      requested = true;
+    }
+  }
+
+  // The round trip counts for the main unit, not for a peer at id 0x00
+  CHECK_EQ(bench.fan.speed, 2);
+  CHECK(bench.fan.getReplyRtt() >= 19);
+  CHECK(bench.fan.getReplyRtt() <= 22);
+}
+
+static void test_fan_query_slow_main_loop() {
+  FanBench bench;
+  std::vector<uint32_t> bursts;
+  uint64_t lastCopy = 0;
+  SimPacket reply;
+
+  // Main loop at a real ESPHome period, the main unit answering 1 ms after the last copy of a query
+  bench.set_loop_period(ESPHOME_LOOP_US);
+  bench.fan.set_update_interval(10000);
+  bench.fan.set_update_interval_max(10000);
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+
+  reply.time = 0;
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    if (bursts.empty() || ((packet.time - lastCopy) > (2 * bench.sim.airtime_us()))) {
+      bursts.push_back(0);
+    }
+    ++bursts.back();
+    lastCopy = packet.time;
+
+    if ((packet.payload[5] == zehnder::FAN_TYPE_QUERY_DEVICE) && (bursts.back() == FAN_TX_FRAMES)) {
+      reply.address = NETWORK_ID;
+      reply.channel = packet.channel;
+      reply.band = packet.band;
+      reply.payload = settings_frame(3, 90, 0);
+      reply.time = packet.time + 1000;
+    }
+  };
+
+  while (time_us() < 40000000ULL) {
+    bench.tick();
+    if ((reply.time != 0) && (time_us() >= reply.time)) {
+      bench.sim.receive(reply);
+      reply.time = 0;
+    }
+  }
+
+  // Every burst exactly FAN_TX_FRAMES copies, every query answered at the first attempt
+  CHECK(bursts.size() >= 3);
+  for (uint32_t copies : bursts) {
+    CHECK_EQ(copies, FAN_TX_FRAMES);
+  }
+  CHECK_EQ(bench.sim.stats.rx_overrun, 0);
+  CHECK_EQ(bench.fan.speed, 3);
+  CHECK_EQ(bench.fan.consecutive_timeouts(), 0);
+  CHECK(bench.fan.connection_healthy_);
+}
+
+// Polls every 2 s with the radio in a low power mode in between; the main unit answers the last copy of every query
+static void fan_radio_idle_mode(nrf905::Mode idleMode, uint32_t loopPeriod) {
+  FanBench bench;
+  uint32_t queries = 0;
+  uint64_t idleTime, receiveTime, transmitTime;
+  SimPacket reply;
+
+  bench.set_loop_period(loopPeriod);
+  bench.fan.set_update_interval(2000);
+  bench.fan.set_update_interval_max(2000);
+  bench.fan.set_radio_idle_mode(idleMode);
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+
+  reply.time = 0;
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    if (packet.payload[5] == zehnder::FAN_TYPE_QUERY_DEVICE) {
+      ++queries;
+      reply.address = NETWORK_ID;
+      reply.channel = packet.channel;
+      reply.band = packet.band;
+      reply.payload = settings_frame(3, 90, 0);
+      reply.time = packet.time + 20000;
+    }
+  };
+  auto run_until = [&](uint64_t end) {
+    while (time_us() < end) {
+      bench.tick();
+      if ((reply.time != 0) && (time_us() >= reply.time)) {
+        bench.sim.receive(reply);
+        reply.time = 0;
+      }
+    }
+  };
+
+  run_until(20000000ULL);
+  CHECK_EQ(bench.fan.speed, 3);
+  idleTime = bench.rf.getModeTime(idleMode);
+  receiveTime = bench.rf.getModeTime(nrf905::Receive);
+  transmitTime = bench.rf.getModeTime(nrf905::Transmit);
+
+  // Woken up before every poll, and back to sleep once the reply is in
+  run_until(70000000ULL);
+  CHECK(queries >= 24 * FAN_TX_FRAMES);
+  CHECK(bench.sim.stats.rx_delivered >= 25);
+  CHECK_EQ(bench.sim.stats.rx_overrun, 0);
+  CHECK_EQ(bench.fan.consecutive_timeouts(), 0);
+  CHECK_EQ(bench.fan.speed, 3);
+  CHECK(bench.fan.connection_healthy_);
+
+  // Most of the 50 s asleep, the rest listening and sending
+  CHECK(bench.rf.getModeTime(idleMode) - idleTime > 40000);
+  CHECK(bench.rf.getModeTime(nrf905::Receive) - receiveTime < 10000);
+  CHECK(bench.rf.getModeTime(nrf905::Transmit) > transmitTime);
+  CHECK(bench.rf.getModeTime(nrf905::Receive) > receiveTime);
+}
+
+static void test_fan_radio_power_down_between_polls() {
+  fan_radio_idle_mode(nrf905::PowerDown, 0);
+  fan_radio_idle_mode(nrf905::PowerDown, ESPHOME_LOOP_US);
+}
+
+static void test_fan_radio_standby_between_polls() {
+  fan_radio_idle_mode(nrf905::Idle, 0);
+  fan_radio_idle_mode(nrf905::Idle, ESPHOME_LOOP_US);
+}
+
+static void test_fan_radio_wakes_to_busy_carrier() {
+  FanBench bench;
+  uint32_t queries = 0;
+  uint64_t firstCopy = 0;
+  SimPacket reply;
+
+  bench.fan.set_update_interval(2000);
+  bench.fan.set_update_interval_max(2000);
+  bench.fan.set_radio_idle_mode(nrf905::PowerDown);
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+
+  reply.time = 0;
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    if (packet.payload[5] == zehnder::FAN_TYPE_QUERY_DEVICE) {
+      if (queries++ == 0) {
+        firstCopy = packet.time;
+      }
+      reply.address = NETWORK_ID;
+      reply.channel = packet.channel;
+      reply.band = packet.band;
+      reply.payload = settings_frame(3, 90, 0);
+      reply.time = packet.time + 20000;
+    }
+  };
+
+  // First poll answered, then asleep until the next one
+  while ((queries == 0) || (bench.rf.getMode() != nrf905::PowerDown)) {
+    bench.tick();
+    if ((reply.time != 0) && (time_us() >= reply.time)) {
+      bench.sim.receive(reply);
+      reply.time = 0;
+    }
+    if (time_us() >= 30000000ULL) {
+      break;
+    }
+  }
+  CHECK_EQ(bench.fan.speed, 3);
+  CHECK_EQ(bench.rf.getMode(), nrf905::PowerDown);
+
+  // Somebody else is on the air when the next poll is due: the radio wakes up, listens and holds back
+  queries = 0;
+  bench.sim.set_carrier(true);
+  bench.run_us(4000000);
+  CHECK_EQ(queries, 0);
+  CHECK_EQ(bench.rf.getMode(), nrf905::Receive);
+
+  // and sends as soon as the channel is free; unanswered, a retry may follow within the window
+  bench.sim.set_carrier(false);
+  bench.run_us(100000);
+  CHECK(queries >= FAN_TX_FRAMES);
+  CHECK(firstCopy >= time_us() - 100000);
+}
+
+static void test_fan_radio_idle_after_busy_engine() {
+  FanBench bench;
+  std::vector<uint8_t> frame = settings_frame(3, 90, 0);
+  uint32_t queries = 0;
+
+  bench.fan.set_radio_idle_mode(nrf905::PowerDown);
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    if (packet.payload[5] == zehnder::FAN_TYPE_QUERY_DEVICE) {
+      ++queries;
+    }
+  };
+
+  // The reply to an earlier attempt handled while the copies of the next are still on air: the engine cannot put
+  // the radio to sleep yet, the protocol side has to ask again once it is done
+  while (queries == 0) {
+    bench.tick();
+  }
+  bench.fan.rfHandleReceived(frame.data(), frame.size());
+  bench.run_us(100000);
+
+  CHECK_EQ(bench.fan.speed, 3);
+  CHECK_EQ(bench.rf.getMode(), nrf905::PowerDown);
+}
+
+static void test_fan_poll_cycle_allocation_free() {
+  FanBench bench;
+  uint32_t queries = 0;
+  SimPacket reply;
+
+  bench.fan.set_update_interval(2000);
+  bench.fan.set_update_interval_max(2000);
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+
+  // Replies up to 30 s, a silent main unit after that, so both the reply and the timeout paths run
+  reply.address = NETWORK_ID;
+  reply.payload = settings_frame(2, 50, 0);
+  reply.time = 0;
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    if ((packet.payload[5] == zehnder::FAN_TYPE_QUERY_DEVICE) && (packet.time < 30000000ULL)) {
+      ++queries;
+      reply.channel = packet.channel;
+      reply.band = packet.band;
+      reply.time = packet.time + 20000;
+    }
+  };
+
+  // Only the component loops are counted; the simulator allocates a packet for every copy on the air
+  allocations = 0;
+  while (time_us() < 60000000ULL) {
+    advance_us(LOOP_TICK_US);
+    bench.sim.step();
+    if ((reply.time != 0) && (time_us() >= reply.time)) {
+      bench.sim.receive(reply);
+      reply.time = 0;
+    }
+    countAllocations = time_us() > 16000000ULL;
+    bench.rf.loop();
+    bench.fan.loop();
+    countAllocations = false;
+  }
+
+  CHECK(queries >= 6 * FAN_TX_FRAMES);
+  CHECK_EQ(bench.fan.speed, 2);
+  CHECK(bench.fan.consecutive_timeouts() > 0);
+  CHECK_EQ(allocations, 0);
+}
+
+static void test_latency_histogram_percentiles() {
+  zehnder::LatencyHistogram histogram;
+
+  CHECK_EQ(histogram.percentile(50), 0);
+
+  // Exact below 8 ms, buckets at most 25% wide above
+  CHECK_EQ(zehnder::LatencyHistogram::bucketLimit(zehnder::LatencyHistogram::bucket(5)), 5);
+  CHECK_EQ(zehnder::LatencyHistogram::bucketLimit(zehnder::LatencyHistogram::bucket(20)), 23);
+  CHECK_EQ(zehnder::LatencyHistogram::bucketLimit(zehnder::LatencyHistogram::bucket(1000)), 1023);
+  CHECK_EQ(zehnder::LatencyHistogram::bucket(1000000), zehnder::LatencyHistogram::BUCKETS - 1);
+
+  for (uint32_t i = 1; i <= 100; ++i) {
+    histogram.add(i * 10);
+  }
+  CHECK_EQ(histogram.count(), 100);
+  CHECK(histogram.percentile(50) >= 500);
+  CHECK(histogram.percentile(50) < 500 * 5 / 4);
+  CHECK(histogram.percentile(95) >= 950);
+  CHECK(histogram.percentile(99) >= 990);
+  CHECK_EQ(histogram.percentile(100), 1023);
+
+  // Saturating bucket halves all of them, percentiles stay put
+  for (uint32_t i = 0; i < 0x10000; ++i) {
+    histogram.add(20);
+  }
+  CHECK(histogram.count() < 0x10000);
+  CHECK_EQ(histogram.percentile(50), 23);
+}
+
+static void test_fan_latency_traced() {
+  FanBench bench;
+  SimPacket reply;
+
+  bench.fan.set_update_interval(10000);
+  bench.fan.set_update_interval_max(10000);
+  bench.setup();
+  bench.fan.set_config(NETWORK_ID, zehnder::FAN_TYPE_REMOTE_CONTROL, MY_ID, zehnder::FAN_TYPE_MAIN_UNIT,
+                       MAIN_UNIT_ID);
+
+  // The main unit answers polls and speed commands 20 ms after the last copy
+  reply.address = NETWORK_ID;
+  reply.time = 0;
+  bench.sim.on_transmit = [&](const SimPacket &packet) {
+    if (packet.payload[5] == zehnder::FAN_TYPE_QUERY_DEVICE) {
+      reply.payload = settings_frame(bench.fan.speed, 50, 0);
+    } else if (packet.payload[5] == zehnder::FAN_FRAME_SETSPEED) {
+      reply.payload = settings_frame(packet.payload[7], 70, 0);
+    } else {
+      return;
+    }
+    reply.channel = packet.channel;
+    reply.band = packet.band;
+    reply.time = packet.time + 20000;
+  };
+
+  // Polls at 15 s (straight from startup, not queued and not traced), 25 s and 42 s, a speed command at 32 s
+  while (time_us() < 50000000ULL) {
+    bench.tick();
+    if ((reply.time != 0) && (time_us() >= reply.time)) {
+      bench.sim.receive(reply);
+      reply.time = 0;
+    }
+    if (time_us() == 32000000ULL) {
+      bench.fan.setSpeed(2);
+    }
+  }
+
+  CHECK_EQ(bench.fan.speed, 2);
+  CHECK(bench.fan.query_latency(TestZehnderRF::LATENCY_TOTAL).count() >= 2);
+  CHECK_EQ(bench.fan.command_latency(TestZehnderRF::LATENCY_TOTAL).count(), 1);
+
+  // Polls: the reply stage is the main unit's 20 ms, on top of four copies on air
+  CHECK(bench.fan.query_latency(TestZehnderRF::LATENCY_REPLY).percentile(50) >= 20);
+  CHECK(bench.fan.query_latency(TestZehnderRF::LATENCY_REPLY).percentile(50) <= 25);
+  CHECK(bench.fan.query_latency(TestZehnderRF::LATENCY_TRANSMIT).percentile(50) > 0);
+  CHECK(bench.fan.getQueryLatency(50) >= 20 + bench.fan.query_latency(TestZehnderRF::LATENCY_TRANSMIT).percentile(0));
+  CHECK(bench.fan.getQueryLatency(99) < 100);
+
+  // The command adds the confirmation sent back to the fan
+  CHECK(bench.fan.command_latency(TestZehnderRF::LATENCY_CONFIRM).percentile(50) > 0);
+  CHECK(bench.fan.getCommandLatency(50) > bench.fan.getQueryLatency(50));
+  CHECK(bench.fan.getCommandLatency(99) < 150);
+  CHECK_EQ(bench.fan.query_latency(TestZehnderRF::LATENCY_CONFIRM).count(), 0);
+}
+
+int main() {
+  static const TestCase cases[] = {
+      {"setup configures chip", test_setup_configures_chip},
+      {"config diff write", test_config_diff_write},
+      {"channel config fast path", test_channel_config_fast_path},
+      {"idle loop without SPI", test_idle_loop_without_spi},
+      {"idle loop polls without pins", test_idle_loop_polls_without_pins},
+      {"RX frame queued", test_rx_frame_queued},
+      {"RX queue overflow", test_rx_queue_overflow},
+      {"RX callback drains queue", test_rx_callback_drains_queue},
+      {"TX auto retransmit", test_tx_auto_retransmit},
+      {"TX auto retransmit polling", test_tx_auto_retransmit_polling},
+      {"TX copies without DR slow loop", test_tx_copies_without_dr_slow_loop},
+      {"TX auto retransmit slow loop", test_tx_auto_retransmit_slow_loop},
+      {"TX from power down does not block", test_tx_from_power_down_does_not_block},
+      {"SPI self-test fallback", test_spi_self_test_fallback},
+      {"batched register access", test_batched_register_access},
+      {"TX payload unchanged skipped", test_tx_payload_unchanged_skipped},
+      {"fan query cycle", test_fan_query_cycle},
+      {"fan repeated polls upload once", test_fan_repeated_polls_upload_once},
+      {"fan commands coalesce and preempt poll", test_fan_commands_coalesce_and_preempt_poll},
+      {"fan stale command dropped", test_fan_stale_command_dropped},
+      {"fan replaced command restarts age", test_fan_replaced_command_restarts_age},
+      {"fan repeated copies handled once", test_fan_repeated_copies_handled_once},
+      {"fan publishes changes only", test_fan_publishes_changes_only},
+      {"fan RF task slow main loop", test_fan_rf_task_slow_main_loop},
+      {"fan broadcast RTT main unit", test_fan_broadcast_rtt_main_unit},
+      {"fan query slow main loop", test_fan_query_slow_main_loop},
+      {"fan radio power down between polls", test_fan_radio_power_down_between_polls},
+      {"fan radio standby between polls", test_fan_radio_standby_between_polls},
+      {"fan radio wakes to busy carrier", test_fan_radio_wakes_to_busy_carrier},
+      {"fan radio idle after busy engine", test_fan_radio_idle_after_busy_engine},
+      {"fan poll cycle allocation free", test_fan_poll_cycle_allocation_free},
+      {"latency histogram percentiles", test_latency_histogram_percentiles},
+      {"fan latency traced", test_fan_latency_traced},
+  };
+
+  return run_tests(cases, sizeof(cases) / sizeof(cases[0]));
+}
@@ -0,0 +1,229 @@
+// Host tests for ZehnderRF on the simulated RF network
+#include "check.h"
+#include "rf_network.h"
+
+using namespace esphome;
+using namespace esphome::host;
+
+static void test_clean_channel() {
+  NetworkScenario scenario = default_scenario();
+  NetworkStats stats;
+
+  scenario.poll_interval_max = scenario.poll_interval;  // Fixed polling
+  scenario.duration = 300000;
+  RfNetwork network(scenario);
+  stats = network.run();
+
+  // Polling starts after 15 s, then every 30 s
+  CHECK(stats.query.count >= 9);
+  CHECK_EQ(stats.query.failed, 0);
+  CHECK_EQ(stats.query.bursts, stats.query.count);  // No retries
+  CHECK_EQ(stats.collisions, 0);
+  CHECK(percentile(stats.query.latency, 100) < 100000);
+  CHECK_EQ(network.bench.fan.speed, network.main_unit.speed);
+  CHECK_EQ(network.bench.fan.voltage, network.main_unit.voltage);
+}
+
+static void test_pairing() {
+  NetworkScenario scenario = default_scenario();
+  NetworkStats stats;
+
+  scenario.paired = false;
+  scenario.duration = 120000;
+  RfNetwork network(scenario);
+  stats = network.run();
+
+  CHECK_EQ(stats.pairing.ok, 1);
+  CHECK(network.main_unit.paired());
+  CHECK_EQ(network.bench.fan.network_id(), 0xA1B2C3D4);
+  CHECK(network.bench.fan.device_id() != 0);
+  CHECK(stats.query.ok >= 1);
+}
+
+static void test_lossy_channel_retries() {
+  NetworkScenario scenario = default_scenario();
+  NetworkStats stats;
+
+  scenario.loss = 0.6;
+  scenario.duration = 600000;
+  RfNetwork network(scenario);
+  stats = network.run();
+
+  CHECK(stats.losses > 0);
+  CHECK(stats.query.bursts > stats.query.count);
+  CHECK(stats.query.ok > 0);
+}
+
+static void test_set_speed() {
+  NetworkScenario scenario = default_scenario();
+  NetworkStats stats;
+
+  scenario.set_speed_interval = 20000;
+  scenario.duration = 300000;
+  RfNetwork network(scenario);
+  stats = network.run();
+
+  CHECK(stats.set_speed.count > 0);
+  CHECK_EQ(stats.set_speed.failed, 0);
+  CHECK_EQ(network.bench.fan.speed, network.main_unit.speed);
+}
+
+static void test_contention_collides() {
+  NetworkScenario scenario = default_scenario();
+  NetworkStats stats;
+
+  scenario.co2_sensors = 3;
+  scenario.remotes = 2;
+  scenario.competitor_interval = 500;
+  scenario.competitor_lbt = false;
+  scenario.duration = 300000;
+  RfNetwork network(scenario);
+  stats = network.run();
+
+  CHECK(stats.collisions > 0);
+  CHECK(stats.query.count > 0);
+  CHECK(stats.nodes.size() == 7);
+}
+
+static void test_repeatable() {
+  NetworkScenario scenario = default_scenario();
+  NetworkStats a, b;
+
+  scenario.loss = 0.2;
+  scenario.co2_sensors = 1;
+  scenario.competitor_interval = 5000;
+  scenario.duration = 200000;
+  {
+    RfNetwork network(scenario);
+    a = network.run();
+  }
+  {
+    RfNetwork network(scenario);
+    b = network.run();
+  }
+
+  CHECK(a.query.latency == b.query.latency);
+  CHECK_EQ(a.collisions, b.collisions);
+  CHECK_EQ(a.losses, b.losses);
+}
+
+static void test_passive_tracking() {
+  NetworkScenario scenario = default_scenario();
+  NetworkStats passive, polling;
+
+  // Other remotes change the speed every now and then; the main unit's replies to them are heard as well
+  scenario.co2_sensors = 1;
+  scenario.remotes = 1;
+  scenario.competitor_interval = 20000;
+  scenario.duration = 600000;
+  {
+    RfNetwork network(scenario);
+    passive = network.run();
+    CHECK_EQ(network.bench.fan.speed, network.main_unit.speed);
+    CHECK_EQ(network.bench.fan.voltage, network.main_unit.voltage);
+  }
+
+  scenario.passive_tracking = false;
+  {
+    RfNetwork network(scenario);
+    polling = network.run();
+  }
+
+  CHECK(passive.query.count * 2 < polling.query.count);
+  CHECK(passive.nodes[0].copies < polling.nodes[0].copies);
+}
+
+static void test_adaptive_polling() {
+  NetworkScenario scenario = default_scenario();
+  NetworkStats adaptive, fixed, commands;
+
+  scenario.duration = 1200000;
+  {
+    RfNetwork network(scenario);
+    adaptive = network.run();
+    // Nothing changed for long, polling has backed off to the ceiling (less jitter)
+    CHECK(network.bench.fan.poll_delay() >= scenario.poll_interval_max * 9 / 10);
+  }
+
+  scenario.poll_interval_max = scenario.poll_interval;
+  {
+    RfNetwork network(scenario);
+    fixed = network.run();
+  }
+
+  // Speed changes bring fast polls back
+  scenario.poll_interval_max = default_scenario().poll_interval_max;
+  scenario.set_speed_interval = 120000;
+  {
+    RfNetwork network(scenario);
+    commands = network.run();
+    CHECK_EQ(network.bench.fan.speed, network.main_unit.speed);
+  }
+
+  CHECK_EQ(adaptive.query.failed, 0);
+  CHECK(adaptive.query.count * 2 < fixed.query.count);
+  CHECK(commands.query.count > adaptive.query.count + commands.set_speed.ok);
+}
+
+static void test_reply_timeout_adapts() {
+  NetworkScenario scenario = default_scenario();
+  NetworkStats stats;
+
+  scenario.loss = 0.5;
+  scenario.poll_interval_max = scenario.poll_interval;
+  scenario.duration = 1200000;
+  RfNetwork network(scenario);
+  stats = network.run();
+
+  // Replies take tens of ms; the window follows, so a lost reply costs far less than the fixed second it used to
+  CHECK(stats.query.bursts > stats.query.count);
+  CHECK_EQ(stats.query.failed, 0);
+  CHECK(network.bench.fan.getReplyRtt() > 0);
+  CHECK(network.bench.fan.getReplyRtt() < 100);
+  CHECK(network.bench.fan.getReplyTimeout() < FAN_REPLY_TIMEOUT);
+  CHECK(percentile(stats.query.latency, 90) < FAN_REPLY_TIMEOUT * 1000);
+}
+
+static void test_loop_period() {
+  NetworkScenario scenario = default_scenario();
+  NetworkStats fast, real;
+
+  scenario.poll_interval_max = scenario.poll_interval;
+  scenario.reply_delay_min = 1000;
+  scenario.reply_delay_max = 3000;
+  scenario.duration = 300000;
+  scenario.loop_period = 0;
+  {
+    RfNetwork network(scenario);
+    fast = network.run();
+  }
+  scenario.loop_period = ESPHOME_LOOP_US;
+  {
+    RfNetwork network(scenario);
+    real = network.run();
+  }
+
+  // A 16 ms main loop costs a few loop passes of latency, but neither extra copies nor missed quick replies
+  CHECK_EQ(real.query.count, fast.query.count);
+  CHECK_EQ(real.query.failed, 0);
+  CHECK_EQ(real.query.bursts, real.query.count);
+  CHECK_EQ(real.nodes[0].copies, fast.nodes[0].copies);
+  CHECK(percentile(real.query.latency, 100) < percentile(fast.query.latency, 100) + 3 * ESPHOME_LOOP_US);
+}
+
+int main() {
+  static const TestCase cases[] = {
+      {"clean channel", test_clean_channel},
+      {"pairing", test_pairing},
+      {"lossy channel retries", test_lossy_channel_retries},
+      {"set speed", test_set_speed},
+      {"contention collides", test_contention_collides},
+      {"repeatable", test_repeatable},
+      {"passive tracking", test_passive_tracking},
+      {"adaptive polling", test_adaptive_polling},
+      {"reply timeout adapts", test_reply_timeout_adapts},
+      {"loop period", test_loop_period},
+  };
+
+  return run_tests(cases, sizeof(cases) / sizeof(cases[0]));
+}
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""
+Test script to build and run the native host tests
+The nRF905 and Zehnder C++ components are compiled for the host against small ESPHome stubs
+and driven by a register level nRF905 simulator (see tests/host/)
+"""
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+HOST_DIR = os.path.join("tests", "host")
+
+COMPONENT_SOURCES = [
+    os.path.join("components", "nrf905", "nRF905.cpp"),
+    os.path.join("components", "zehnder", "zehnder.cpp"),
+]
+
+HARNESS_SOURCES = [
+    os.path.join(HOST_DIR, "stubs", "host_stubs.cpp"),
+    os.path.join(HOST_DIR, "nrf905_sim.cpp"),
+    os.path.join(HOST_DIR, "check.cpp"),
+]
+
+# Host programs: name, extra sources, arguments to run them with, libraries (skipped when missing)
+HOST_PROGRAMS = [
+    ("test_nrf905", [os.path.join(HOST_DIR, "test_nrf905.cpp")], [], []),
+    ("test_frame_codec", [os.path.join(HOST_DIR, "test_frame_codec.cpp")], [], []),
+    ("test_rf_network", [os.path.join(HOST_DIR, "rf_network.cpp"),
+                         os.path.join(HOST_DIR, "test_rf_network.cpp")], [], []),
+    ("netsim", [os.path.join(HOST_DIR, "rf_network.cpp"),
+                os.path.join(HOST_DIR, "netsim.cpp")],
+     ["--duration", "120", "--loss", "0.1", "--co2", "1", "--remotes", "1", "--competitor-interval", "10000"], []),
+    # Fuzz target without libFuzzer: the regression corpus plus a fixed set of mutations
+    ("fuzz_rf_handle_received", [os.path.join(HOST_DIR, "fuzz_rf_handle_received.cpp"),
+                                 os.path.join(HOST_DIR, "fuzz_replay.cpp")],
+     [os.path.join(HOST_DIR, "corpus", "rf_handle_received"), "--random", "5000"], []),
+    # Google Benchmark; a short run here only checks that it works, run it by hand for numbers
+    ("bench_codecs", [os.path.join(HOST_DIR, "bench_codecs.cpp")],
+     ["--benchmark_min_time=0.001"], [("benchmark/benchmark.h", "benchmark"), (None, "pthread")]),
+]
+
+
+def find_compiler():
+    """Find a C++17 capable host compiler"""
+    for compiler in [os.environ.get("CXX"), "g++", "clang++", "c++"]:
+        if compiler and shutil.which(compiler):
+            return compiler
+    return None
+
+
+def has_library(compiler, header, library):
+    """Check that a header and library can be used"""
+    source = f"#include <{header}>\nint main() {{ return 0; }}\n" if header else "int main() { return 0; }\n"
+    try:
+        result = subprocess.run([compiler, "-x", "c++", "-", "-o", os.devnull, f"-l{library}"],
+                                input=source, capture_output=True, text=True, timeout=60)
+        return result.returncode == 0
+    except subprocess.TimeoutExpired:
+        return False
+
+
+def make_include_dir(tmpdir):
+    """Expose the components under their ESPHome include paths"""
+    include_dir = os.path.join(tmpdir, "include")
+    components_dir = os.path.join(include_dir, "esphome", "components")
+    os.makedirs(components_dir)
+    for component in ["nrf905", "zehnder"]:
+        os.symlink(os.path.abspath(os.path.join("components", component)),
+                   os.path.join(components_dir, component))
+    return include_dir
+
+
+def build(compiler, include_dir, output, sources, libraries):
+    """Compile one host program"""
+    cmd = [compiler, "-std=gnu++17", "-O1", "-g", "-Wall", "-Wextra", "-Werror",
+           "-Wno-unused-variable", "-Wno-unused-but-set-variable",
+           "-I", os.path.join(HOST_DIR, "stubs"), "-I", HOST_DIR, "-I", include_dir,
+           "-o", output] + sources + [f"-l{library}" for _, library in libraries]
+    try:
+        result = subprocess.run(cmd, capture_output=True, text=True, timeout=300)
+        return result.returncode == 0, result.stderr
+    except subprocess.TimeoutExpired:
+        return False, "Timeout during compilation"
+
+
+def run(program, args):
+    """Run one host program"""
+    try:
+        result = subprocess.run([program] + args, capture_output=True, text=True, timeout=300)
+        return result.returncode == 0, result.stdout + result.stderr
+    except subprocess.TimeoutExpired:
+        return False, "Timeout while running"
+
+
+def main():
+    """Main test function"""
+    print("🔍 Native host tests")
+    print("====================")
+
+    # Check if we're in the right directory
+    if not os.path.exists("components"):
+        print("❌ Please run this test from the project root directory")
+        sys.exit(1)
+
+    compiler = find_compiler()
+    if compiler is None:
+        print("⚠️  No host C++ compiler found, skipping native host tests")
+        sys.exit(0)
+
+    all_passed = True
+
+    with tempfile.TemporaryDirectory() as tmpdir:
+        include_dir = make_include_dir(tmpdir)
+
+        for name, sources, args, libraries in HOST_PROGRAMS:
+            print(f"\n📋 Building: {name}")
+            print("-" * 50)
+
+            missing = [library for header, library in libraries if not has_library(compiler, header, library)]
+            if missing:
+                print(f"⚠️  {name} - Skipped, missing libraries: {', '.join(missing)}")
+                continue
+
+            output = os.path.join(tmpdir, name)
+            success, stderr = build(compiler, include_dir, output,
+                                    COMPONENT_SOURCES + HARNESS_SOURCES + sources, libraries)
+            if not success:
+                print(f"❌ {name} - Compilation FAILED")
+                print(stderr)
+                all_passed = False
+                continue
+            if stderr:
+                print(stderr)
+
+            success, output = run(output, args)
+            print(output)
+            if success:
+                print(f"✅ {name} - PASSED")
+            else:
+                print(f"❌ {name} - FAILED")
+                all_passed = False
+
+    print("\n" + "=" * 50)
+    if all_passed:
+        print("🎉 All native host tests passed!")
+        sys.exit(0)
+    else:
+        print("💥 Some native host tests failed!")
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()